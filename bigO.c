@@ -203,10 +203,48 @@
  */
 
 /* (Some setup) */
+/* build: cc -O2 -pthread bigO.c -lm */
+/* offload: cc -O2 -pthread -fopenmp -DBIGO_OFFLOAD bigO.c -lm */
+/* for cpu affinity */
+#define _GNU_SOURCE
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
 #include<time.h>
 #include<math.h>
+#include<pthread.h>
+#include<sched.h>
+#include<stdatomic.h>
+#include<errno.h>
+#include<stdint.h>
+#include<limits.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<regex.h>
+#ifdef __linux__
+#include<sys/ioctl.h>
+#include<sys/syscall.h>
+#include<linux/perf_event.h>
+#include<linux/mempolicy.h>
+#if __has_include(<linux/io_uring.h>)
+#include<linux/io_uring.h>
+#define BIGO_IO_URING
+#endif
+#endif
+#ifdef BIGO_OFFLOAD
+#ifndef _OPENMP
+#error "BIGO_OFFLOAD needs OpenMP target support (eg: -fopenmp)"
+#endif
+#include<omp.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include<immintrin.h>
+#include<cpuid.h>
+#elif defined(__aarch64__)
+#include<arm_neon.h>
+#endif
 
 enum OClass {
     O1,
@@ -221,23 +259,102 @@ enum OClass {
 };
 
 #define UNUSED(x) (void)(x)
+/* Every algorithm sends what it
+ * worked out to RESULT. The
+ * value is kept (for --verify)
+ * and the barrier after it
+ * tells the compiler any memory
+ * may have changed - so it can
+ * neither drop the work that
+ * made the value nor hoist it
+ * out of a loop of calls.
+ */
+static _Thread_local double bench_result;
+#define CLOBBER() __asm__ volatile("" : : : "memory")
 #ifdef DUMP_RESULT
-    #define RESULT(x) printf("%s\n",#x)
+    #define RESULT(x) do { bench_result = (x); printf("%s\n",#x); } while(0)
 #else
-    static long _dummy;
-    #define RESULT(x) (_dummy=1)
+    #define RESULT(x) do { bench_result = (x); CLOBBER(); } while(0)
 #endif
+/* what the searches report */
+#define FOUND 1
+#define NOT_FOUND 0
+
+/* Set when an algorithm has run
+ * past its time budget. Long
+ * running algorithms check it
+ * now and then and give up.
+ */
+static _Thread_local atomic_int *bench_cancel;
+/* [=] Set on the threads of the
+ * concurrent runner */
+static _Thread_local int bench_runner;
+#define CANCELLED() (bench_cancel && atomic_load_explicit(bench_cancel, memory_order_relaxed))
+
+/* [=] Monotonic wall clock in
+ * nanoseconds
+ */
+long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
 
 /* The environment ties
  * the algorithms, their
  * descriptions, and their data.
  */
 typedef void (*func)(void* data);
+/* [=] A kernel makes `iters`
+ * back to back calls of one
+ * algorithm - see KERNEL */
+typedef void (*kernel)(void* data, long iters);
 struct environment {
+    char *name;
     long n;
-    func algo;
+    kernel algo;
     void *data;
     enum OClass oclass;
+    /* optional hooks called with
+     * the fixture around each
+     * timed run (but not timed) */
+    func setup;
+    func teardown;
+    void *fixture;
+    /* runs on `bench_pool` so
+     * show how it scales with the
+     * number of threads */
+    int parallel;
+    /* queries answered per run -
+     * shown as queries/second */
+    long queries;
+    /* the memory `data` takes, to
+     * show as bytes per element
+     * (0 = not shown) */
+    long bytes;
+    /* what was left behind, for
+     * --verify to compare, when
+     * that is the result (sorts) */
+    double (*digest)(struct environment *environment);
+    /* host<->device copies (untimed)
+     * for the offload rows */
+    long long to_device_ns;
+    long long from_device_ns;
+    /* bytes read from disk and the
+     * time spent waiting on it, for
+     * the stream rows */
+    long long io_bytes;
+    long long io_wait_ns;
+    /* tidies up `data` when done
+     * with the environment, before
+     * its arena goes */
+    func release;
+    struct arena *arena;
+    /* environments with the same
+     * (non NULL) key change the
+     * same data so never run at
+     * the same time */
+    void *exclusive;
 };
 
 struct array {
@@ -245,6 +362,16 @@ struct array {
     int *vals;
 };
 
+/* A fresh copy of `from` is
+ * made into `to` before each
+ * run of algorithms that change
+ * their input.
+ */
+struct array_copy {
+    struct array *from;
+    struct array *to;
+};
+
 struct search {
     int needle;
     struct array *haystack;
@@ -258,6 +385,25 @@ struct range_sum {
     struct array *array;
 };
 
+/* Moves can be written into a
+ * buffer of `max_moves` that is
+ * handed to `flush` each time it
+ * fills (or just counted if
+ * there is no buffer).
+ */
+struct hanoi_move {
+    unsigned char disk;
+    unsigned char from_peg;
+    unsigned char to_peg;
+};
+struct hanoi {
+    long num;
+    struct hanoi_move *moves;
+    long max_moves;
+    void (*flush)(struct hanoi *hanoi, long count);
+    unsigned long long checksum;
+};
+
 /**
  * flash.png
  */
@@ -322,8 +468,8 @@ void binary_jump_search(struct search *s) {
         while(pos + jump < s->haystack->sz && s->haystack->vals[pos+jump] <= s->needle) pos+=jump;
         jump = jump / 2;
     }
-    if(s->haystack->vals[pos] == s->needle) RESULT("Found needle!");
-    else RESULT("Needle not found!");
+    if(s->haystack->vals[pos] == s->needle) RESULT(FOUND);
+    else RESULT(NOT_FOUND);
 }
 
 /**
@@ -351,37 +497,50 @@ void binary_jump_search(struct search *s) {
  *  Grover’s algorithm,
  *  [href=http://www.infoarena.ro/blog/square-root-trick](the square root trick)
  */
-void range_sum_query(struct range_sum* rs) {
+long range_sum_1(struct range_sum* rs, long from, long to) {
     long sum = 0;
-    int i = rs->from;
-    while((i+1)%rs->root_sz != 0 && i <= rs->to) {
+    long i = from;
+    while(i%rs->root_sz != 0 && i <= to) {
         sum += rs->array->vals[i++];
     }
-    while(i + rs->root_sz <= rs->to) {
+    while(i + rs->root_sz <= to) {
         sum += rs->slice_sum[i/rs->root_sz];
         i += rs->root_sz;
     }
-    while(i <= rs->to) {
+    while(i <= to) {
         sum += rs->array->vals[i++];
     }
-    RESULT(sum);
+    return sum;
+}
+void range_sum_query(struct range_sum* rs) {
+    RESULT(range_sum_1(rs, rs->from, rs->to));
 }
 void setup_slice_sums(struct range_sum* rs) {
-    int i;
+    long i, slice;
 
     rs->root_sz = (long)sqrt(rs->array->sz);
 
-    int max_slice = rs->array->sz/rs->root_sz;
-    int num_slices = max_slice + 1;
+    long max_slice = rs->array->sz/rs->root_sz;
+    long num_slices = max_slice + 1;
 
     rs->slice_sum = malloc(sizeof(long)*num_slices);
-    for(i = 0;i < num_slices;i++) {
-        rs->slice_sum[i] = 0;
-    }
-    for(i = 0;i < rs->array->sz;i++) {
-        rs->slice_sum[i/rs->root_sz] += rs->array->vals[i];
+    for(slice = 0;slice < num_slices;slice++) {
+        long end = (slice + 1)*rs->root_sz;
+        if(end > rs->array->sz) end = rs->array->sz;
+        rs->slice_sum[slice] = 0;
+        for(i = slice*rs->root_sz;i < end;i++) {
+            rs->slice_sum[slice] += rs->array->vals[i];
+        }
     }
 }
+/* Updating an item only changes
+ * the one slice it is in:
+ *  O(1)
+ */
+void range_sum_update(struct range_sum* rs, long idx, int val) {
+    rs->slice_sum[idx/rs->root_sz] += (long)val - rs->array->vals[idx];
+    rs->array->vals[idx] = val;
+}
 
 /**
  * clark-kent.png
@@ -414,11 +573,11 @@ void linear_search(struct search *s) {
 
     for(i = 0;i < s->haystack->sz;i++) {
         if(s->haystack->vals[i] == s->needle) {
-            RESULT("Found needle!");
+            RESULT(FOUND);
             return;
         }
     }
-    RESULT("Needle Not Found!");
+    RESULT(NOT_FOUND);
 }
 
 /**
@@ -541,7 +700,7 @@ void find_max_seq_sum(struct array* array) {
     double max_sum = 0;
     int i,j;
 
-    for(i = 0;i < array->sz;i++) {
+    for(i = 0;i < array->sz && !CANCELLED();i++) {
         double curr_sum = 0;
         for(j = i;j < array->sz;j++) {
             curr_sum += array->vals[j];
@@ -592,14 +751,17 @@ void find_max_seq_sum(struct array* array) {
  * Tower of Hanoi, Naive
  * Finonacci Calculation,...
  */
-void solve_hanoi_1(long num, int from_peg, int to_peg, int spare_peg) {
-    if(num < 1) return;
-    if(num > 1) solve_hanoi_1(num-1, from_peg, spare_peg, to_peg);
-    RESULT("move remaining one from_peg -> to_peg");
-    if(num > 1) solve_hanoi_1(num-1, spare_peg, to_peg, from_peg);
+void solve_hanoi_1(struct hanoi *hanoi, long num, int from_peg, int to_peg, int spare_peg) {
+    if(num < 1 || (num > 16 && CANCELLED())) return;
+    if(num > 1) solve_hanoi_1(hanoi, num-1, from_peg, spare_peg, to_peg);
+    /* move remaining one from_peg -> to_peg */
+    hanoi->checksum += (num-1) ^ (from_peg << 6) ^ (to_peg << 8);
+    if(num > 1) solve_hanoi_1(hanoi, num-1, spare_peg, to_peg, from_peg);
 }
-void solve_hanoi(int num) {
-    solve_hanoi_1(num, 1, 2, 3);
+void solve_hanoi(struct hanoi *hanoi) {
+    hanoi->checksum = 0;
+    solve_hanoi_1(hanoi, hanoi->num, 1, 2, 3);
+    RESULT(hanoi->checksum);
 }
 
 /**
@@ -644,195 +806,6386 @@ void solve_hanoi(int num) {
  */
 
 
-/* (actually run algos and show results) */
+/* (thread pool) */
 
-char* oclass_1_str(enum OClass oclass) {
-    switch(oclass) {
-        case O1: return "O(1)";
-        case O_logn: return "O(log(n))";
-        case O_sqrtn: return "O(sqrt(n))";
-        case O_n: return "O(n)";
-        case O_nlogn: return "O(n log(n))";
-        case O_n_power_2: return "O(n^2)";
-        case O_2_power_n: return "O(2^n)";
-        case O_n_permut: return "O(n!)";
-        case O_n_power_n: return "O(n^n)";
-        default: return "ERROR!";
+/* A task is a function and the
+ * range of data it works on.
+ * `pending` counts the unfinished
+ * tasks of the job it belongs
+ * to.
+ */
+struct task {
+    void (*run)(struct task *task);
+    void *data;
+    long low;
+    long high;
+    atomic_long *pending;
+    atomic_int *cancel;
+};
+
+/* Each thread pushes and pops
+ * its own tasks at the bottom of
+ * its deque while idle threads
+ * steal from the top.
+ */
+#define POOL_DEQUE_SZ 4096
+struct deque {
+    pthread_mutex_t lock;
+    long top;
+    long bottom;
+    struct task tasks[POOL_DEQUE_SZ];
+};
+
+struct pool {
+    int num_threads;
+    pthread_t *threads;
+    struct deque *deques;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_long queued;
+    int stop;
+};
+
+/* The deque of the current
+ * thread (the caller of the pool
+ * is always deque 0).
+ */
+static _Thread_local int pool_self;
+
+/* The pool the parallel engines
+ * run on.
+ */
+static struct pool *bench_pool;
+
+/* When set each worker pins
+ * itself to its own cpu from
+ * here (wrapping round) instead
+ * of sharing its creator's.
+ */
+static int *pool_cpus;
+static int pool_num_cpus;
+
+void pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+int deque_push(struct deque *deque, struct task *task) {
+    int ok = 0;
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom - deque->top < POOL_DEQUE_SZ) {
+        deque->tasks[deque->bottom++ % POOL_DEQUE_SZ] = *task;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
+}
+int deque_pop(struct deque *deque, struct task *task) {
+    int ok = 0;
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom > deque->top) {
+        *task = deque->tasks[--deque->bottom % POOL_DEQUE_SZ];
+        ok = 1;
     }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
 }
-void show_time_msg_1(clock_t begin, clock_t end) {
-    printf("%lf", (double)(end - begin));
+int deque_steal(struct deque *deque, struct task *task) {
+    int ok = 0;
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom > deque->top) {
+        *task = deque->tasks[deque->top++ % POOL_DEQUE_SZ];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return ok;
 }
-void show_time_taken(struct environment* environment) {
-    clock_t begin,end;
 
-    if(!environment->data) {
-        printf("%-12s(%ld items): (Not executed)\n",
-            oclass_1_str(environment->oclass),
-            environment->n);
+/* [=] Find work: our own newest
+ * task first, otherwise steal
+ * the oldest from someone else
+ */
+int pool_find_task(struct pool *pool, struct task *task) {
+    int i;
+
+    if(deque_pop(&pool->deques[pool_self], task)) return 1;
+    for(i = 1;i < pool->num_threads;i++) {
+        int victim = (pool_self + i) % pool->num_threads;
+        if(deque_steal(&pool->deques[victim], task)) return 1;
+    }
+    return 0;
+}
+/* [=] Run a task as part of the
+ * benchmark that queued it - so
+ * it sees the same cancel flag
+ */
+void pool_run_task(struct pool *pool, struct task *task) {
+    atomic_long *pending = task->pending;
+    atomic_int *cancel = bench_cancel;
+
+    atomic_fetch_sub(&pool->queued, 1);
+    bench_cancel = task->cancel;
+    task->run(task);
+    bench_cancel = cancel;
+    atomic_fetch_sub(pending, 1);
+}
+
+/* [=] Queue a task (or just run
+ * it if our deque is full)
+ */
+void pool_submit(struct pool *pool, struct task *task) {
+    task->cancel = bench_cancel;
+    atomic_fetch_add(task->pending, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    if(!deque_push(&pool->deques[pool_self], task)) {
+        pool_run_task(pool, task);
         return;
     }
+    if(pool->num_threads > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
 
-    printf("%-12s(%ld items): ",
-            oclass_1_str(environment->oclass),
-            environment->n);
-    fflush(stdout);
+/* [=] Help run tasks until all
+ * the tasks of a job are done
+ */
+void pool_wait(struct pool *pool, atomic_long *pending) {
+    struct task task;
+
+    while(atomic_load(pending) > 0) {
+        if(pool_find_task(pool, &task)) pool_run_task(pool, &task);
+        else sched_yield();
+    }
+}
 
-    begin = clock();
-    environment->algo(environment->data);
-    end = clock();
+struct pool_start {
+    struct pool *pool;
+    int self;
+};
+void* pool_worker(void *arg) {
+    struct pool_start *start = arg;
+    struct pool *pool = start->pool;
+    struct task task;
 
-    show_time_msg_1(begin, end);
-    printf("\n");
+    pool_self = start->self;
+    free(start);
+    if(pool_cpus) pin_to_cpu(pool_cpus[pool_self % pool_num_cpus]);
+
+    for(;;) {
+        int stop;
+
+        if(pool_find_task(pool, &task)) {
+            pool_run_task(pool, &task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        while(!pool->stop && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        stop = pool->stop;
+        pthread_mutex_unlock(&pool->lock);
+        if(stop) break;
+        sched_yield();
+    }
+    return NULL;
 }
 
-/* [=] Show results of running
- * all algos in their
- * environments.
+struct pool* pool_create(int num_threads) {
+    struct pool *pool = malloc(sizeof(struct pool));
+    int i;
+
+    pool->num_threads = num_threads;
+    pool->threads = malloc(sizeof(pthread_t)*num_threads);
+    pool->deques = malloc(sizeof(struct deque)*num_threads);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    atomic_init(&pool->queued, 0);
+    pool->stop = 0;
+    for(i = 0;i < num_threads;i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].top = 0;
+        pool->deques[i].bottom = 0;
+    }
+    for(i = 1;i < num_threads;i++) {
+        struct pool_start *start = malloc(sizeof(struct pool_start));
+        start->pool = pool;
+        start->self = i;
+        pthread_create(&pool->threads[i], NULL, pool_worker, start);
+    }
+    return pool;
+}
+void pool_destroy(struct pool *pool) {
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for(i = 1;i < pool->num_threads;i++) pthread_join(pool->threads[i], NULL);
+    for(i = 0;i < pool->num_threads;i++) pthread_mutex_destroy(&pool->deques[i].lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
+
+
+/* (arena) */
+
+/* Everything made for one size
+ * comes out of an arena so it
+ * all goes in one step when the
+ * size is done. Small things are
+ * carved out of blocks, big ones
+ * get their own mapping (with
+ * huge pages so the TLB isn't
+ * what we measure). It's all
+ * fresh from mmap so starts out
+ * zeroed.
+ */
+#define ARENA_BLOCK (1L << 20)
+#define ARENA_ALIGN 64
+struct arena_map {
+    void *p;
+    size_t bytes;
+    struct arena_map *next;
+};
+struct arena {
+    struct arena_map *maps;
+    char *top;
+    size_t left;
+    size_t bytes;
+    /* NUMA node to put it all on
+     * (-1 for wherever) */
+    int node;
+};
+/* [=] The arena setups allocate
+ * from - outside of one it's
+ * just malloc
+ */
+static struct arena *bench_arena;
+
+struct arena* arena_create(int node) {
+    struct arena *arena = calloc(1, sizeof(struct arena));
+    arena->node = node;
+    return arena;
+}
+/* [=] Hand a mapping to the
+ * arena to unmap on release
+ */
+void arena_adopt(struct arena *arena, void *p, size_t bytes) {
+    struct arena_map *map = malloc(sizeof(struct arena_map));
+    map->p = p;
+    map->bytes = bytes;
+    map->next = arena->maps;
+    arena->maps = map;
+    arena->bytes += bytes;
+}
+void* arena_map_1(struct arena *arena, size_t bytes) {
+    void *p = mmap(NULL, bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+    if(bytes >= ARENA_BLOCK) madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+#if defined(__linux__) && defined(SYS_mbind)
+    /* before anything touches it
+     * so whichever thread fills it
+     * the pages land on the node */
+    if(arena->node >= 0 && arena->node < 64) {
+        unsigned long mask = 1UL << arena->node;
+        syscall(SYS_mbind, p, bytes, MPOL_PREFERRED, &mask, 64, 0);
+    }
+#endif
+    arena_adopt(arena, p, bytes);
+    return p;
+}
+void* arena_alloc(size_t bytes) {
+    struct arena *arena = bench_arena;
+    void *p;
+
+    if(!arena) return calloc(1, bytes ? bytes : 1);
+    bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if(bytes > ARENA_BLOCK/4) return arena_map_1(arena, bytes);
+    if(bytes > arena->left) {
+        arena->top = arena_map_1(arena, ARENA_BLOCK);
+        arena->left = arena->top ? ARENA_BLOCK : 0;
+        if(!arena->top) return NULL;
+    }
+    p = arena->top;
+    arena->top += bytes;
+    arena->left -= bytes;
+    return p;
+}
+/* [=] Free everything in one
+ * step
+ */
+void arena_release(struct arena *arena) {
+    while(arena->maps) {
+        struct arena_map *map = arena->maps;
+        arena->maps = map->next;
+        munmap(map->p, map->bytes);
+        free(map);
+    }
+    free(arena);
+}
+
+
+/* (random numbers) */
+
+/* Counter based random numbers:
+ * number `i` of a seed is just a
+ * hash of (seed, i), so any
+ * thread can make any part of a
+ * sequence and get the same
+ * numbers.
+ */
+uint64_t splitmix64_1(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+uint64_t random_at(uint64_t seed, uint64_t i) {
+    return splitmix64_1(seed + (i + 1) * 0x9E3779B97F4A7C15ULL);
+}
+/* [=] A non-negative int - the
+ * same range as rand()
+ */
+int random_int_at(uint64_t seed, uint64_t i) {
+    return (int)(random_at(seed, i) >> 33);
+}
+
+/* A sequence of random numbers
+ * for the one-off picks (needles,
+ * ranges, points...).
+ */
+struct rng {
+    uint64_t seed;
+    uint64_t i;
+};
+struct rng rng_create(uint64_t seed, uint64_t stream) {
+    struct rng rng;
+    rng.seed = splitmix64_1(seed ^ splitmix64_1(stream));
+    rng.i = 0;
+    return rng;
+}
+int rng_int(struct rng *rng) {
+    return random_int_at(rng->seed, rng->i++);
+}
+/* [=] Uniform in [0, n) */
+long rng_below(struct rng *rng, long n) {
+    return (long)(random_at(rng->seed, rng->i++) % (uint64_t)n);
+}
+double rng_double(struct rng *rng) {
+    return (random_at(rng->seed, rng->i++) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/* (alternate engines) */
+
+/* [=] Insertion sort for the
+ * small ranges left over by
+ * intro_sort
  */
-void show_algo_results(struct environment* environments) {
-    while(environments->algo) {
-        show_time_taken(environments);
-        environments++;
+void insertion_sort_1(int* array, long low, long high) {
+    long i, j;
+
+    for(i = low + 1;i <= high;i++) {
+        int val = array[i];
+        for(j = i;j > low && array[j-1] > val;j--) array[j] = array[j-1];
+        array[j] = val;
     }
 }
+void sift_down_1(int* array, long low, long root, long end) {
+    int val = array[low + root];
+    long child;
 
-/* [=] Return a large, random
- * array
+    while((child = 2*root + 1) < end) {
+        if(child + 1 < end && array[low+child+1] > array[low+child]) child++;
+        if(array[low+child] <= val) break;
+        array[low+root] = array[low+child];
+        root = child;
+    }
+    array[low+root] = val;
+}
+/* [=] Heap sort - the fallback
+ * when intro_sort recurses too
+ * deep. O(n log(n)) whatever
+ * the input.
  */
-int* create_int_array(long sz) {
+void heap_sort_1(int* array, long low, long high) {
+    long n = high - low + 1;
     long i;
-    int *array = malloc(sz*sizeof(int));
-    for(i = 0;i < sz;i++) {
-        array[i] = rand();
+
+    for(i = n/2 - 1;i >= 0;i--) sift_down_1(array, low, i, n);
+    for(i = n - 1;i > 0;i--) {
+        int tmp = array[low];
+        array[low] = array[low+i];
+        array[low+i] = tmp;
+        sift_down_1(array, low, 0, i);
     }
-    return array;
 }
+int median_of_3_1(int a, int b, int c) {
+    if(a < b) {
+        if(b < c) return b;
+        return a < c ? c : a;
+    }
+    if(a < c) return a;
+    return b < c ? c : b;
+}
+/* [=] Median of three for small
+ * ranges, Tukey's ninther for
+ * large ones
+ */
+int choose_pivot_1(int* array, long low, long high) {
+    long mid = low + (high - low)/2;
+    long step;
 
-/* [=] dummy function
- * for not implemented
- * algorithms.
+    if(high - low < 128) return median_of_3_1(array[low], array[mid], array[high]);
+
+    step = (high - low)/8;
+    return median_of_3_1(
+            median_of_3_1(array[low], array[low+step], array[low+2*step]),
+            median_of_3_1(array[mid-step], array[mid], array[mid+step]),
+            median_of_3_1(array[high-2*step], array[high-step], array[high]));
+}
+/* [=] Dutch flag partition:
+ *  [low, *lt)  < pivot
+ *  [*lt, *gt]  == pivot
+ *  (*gt, high] > pivot
+ * so runs of duplicates are
+ * done with in one pass.
  */
-void do_nothing(void* data) {
+void partition_3way_1(int* array, long low, long high, int pivot, long *lt, long *gt) {
+    long l = low, i = low, g = high;
+
+    while(i <= g) {
+        int val = array[i];
+        if(val < pivot) {
+            array[i++] = array[l];
+            array[l++] = val;
+        } else if(val > pivot) {
+            array[i] = array[g];
+            array[g--] = val;
+        } else {
+            i++;
+        }
+    }
+    *lt = l;
+    *gt = g;
 }
+#define INTRO_SORT_CUTOFF 16
+/* [=] Recurse into the smaller
+ * side and loop on the larger
+ * one so the stack never grows
+ * past log(n).
+ */
+void intro_sort_1(int* array, long low, long high, int depth) {
+    long lt, gt;
 
-/* [=] Setup the environment for
- * various algorithms
+    while(high - low + 1 > INTRO_SORT_CUTOFF) {
+        if(depth-- == 0) {
+            heap_sort_1(array, low, high);
+            return;
+        }
+        partition_3way_1(array, low, high, choose_pivot_1(array, low, high), &lt, &gt);
+        if(lt - low < high - gt) {
+            intro_sort_1(array, low, lt-1, depth);
+            low = gt + 1;
+        } else {
+            intro_sort_1(array, gt+1, high, depth);
+            high = lt - 1;
+        }
+    }
+    insertion_sort_1(array, low, high);
+}
+void intro_sort(struct array *array) {
+    int depth = array->sz > 1 ? 2 * (int)log2(array->sz) : 0;
+    intro_sort_1(array->vals, 0, array->sz-1, depth);
+}
+
+/* Partitions smaller than this
+ * are sorted serially - below it
+ * a task costs more than it
+ * saves.
  */
-struct environment* create_environments(long sz) {
-    int i = 0;
-
-    time_t t;
-    srand((unsigned) time(&t));
-
-    /* Setup a large block of
-     * enviroments.
-     * NB: if the number of
-     * algo's > 100 this should
-     * be changed
-     */
-    struct environment *environments = malloc(sizeof(struct environment)*100);
-    struct environment *environment;
+#define PARALLEL_SORT_GRAIN 16384
+/* [=] quick_sort_1 that hands
+ * the right side of every large
+ * partition to the pool and
+ * keeps going on the left
+ */
+void parallel_quick_sort_1(struct task *task) {
+    int *array = task->data;
+    long low = task->low, high = task->high;
 
-    /* setup data */
-    struct array *sorted_array = malloc(sizeof(struct array));
-    sorted_array->sz = sz;
-    sorted_array->vals = create_int_array(sorted_array->sz);
-    quick_sort(sorted_array);
+    while(high - low > PARALLEL_SORT_GRAIN) {
+        long pivot = partition_1(array, low, high);
+        struct task right = *task;
+        right.low = pivot + 1;
+        right.high = high;
+        pool_submit(bench_pool, &right);
+        high = pivot - 1;
+    }
+    quick_sort_1(array, low, high);
+}
+void parallel_quick_sort(struct array *array) {
+    atomic_long pending;
+    struct task task;
+
+    atomic_init(&pending, 0);
+    task.run = &parallel_quick_sort_1;
+    task.data = array->vals;
+    task.low = 0;
+    task.high = array->sz-1;
+    task.pending = &pending;
+    pool_submit(bench_pool, &task);
+    pool_wait(bench_pool, &pending);
+}
+
+/* A radix sort works out of
+ * `scratch` - allocated once
+ * and reused across runs.
+ */
+struct radix_sort {
+    struct array *array;
+    int *scratch;
+};
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((int)(sizeof(int) * 8 / RADIX_BITS))
+#define RADIX_PREFETCH 64
+/* [=] LSD radix sort. One pass
+ * builds the histograms of every
+ * digit, then each digit is a
+ * stable scatter - skipped when
+ * all keys share that digit.
+ * O(n) - no comparisons!
+ */
+void radix_sort(struct radix_sort *rs) {
+    long counts[RADIX_PASSES][RADIX_BUCKETS];
+    long n = rs->array->sz;
+    unsigned *from = (unsigned*)rs->array->vals;
+    unsigned *to = (unsigned*)rs->scratch;
+    long i;
+    int pass, d;
 
-    struct array *array = malloc(sizeof(struct array));
-    array->sz = sz;
-    array->vals = create_int_array(array->sz);
+    memset(counts, 0, sizeof(counts));
+    for(i = 0;i < n;i++) {
+        /* flipping the sign bit
+         * orders negatives first */
+        unsigned key = from[i] ^ 0x80000000u;
+        __builtin_prefetch(&from[i + RADIX_PREFETCH]);
+        for(pass = 0;pass < RADIX_PASSES;pass++) {
+            counts[pass][(key >> (pass*RADIX_BITS)) & (RADIX_BUCKETS-1)]++;
+        }
+    }
 
-    struct array *mutable_array = malloc(sizeof(struct array));
-    mutable_array->sz = sz;
-    mutable_array->vals = create_int_array(mutable_array->sz);
+    for(pass = 0;pass < RADIX_PASSES;pass++) {
+        long *count = counts[pass];
+        long offset = 0;
+        int shift = pass*RADIX_BITS;
+        unsigned *tmp;
 
-    struct search *search = malloc(sizeof(struct search));
-    search->haystack = sorted_array;
-    search->needle = sorted_array->vals[rand()%(sorted_array->sz)];
+        if(n == 0 || count[((from[0] ^ 0x80000000u) >> shift) & (RADIX_BUCKETS-1)] == n) continue;
 
-    struct range_sum *rs = malloc(sizeof(struct range_sum));
-    rs->array = array;
-    setup_slice_sums(rs);
-    rs->from = rand()%(rs->array->sz);
-    rs->to = rand()%(rs->array->sz);
-    while(rs->from < rs->to) {
-        rs->from = rand()%(rs->array->sz);
-        rs->to = rand()%(rs->array->sz);
+        for(d = 0;d < RADIX_BUCKETS;d++) {
+            long c = count[d];
+            count[d] = offset;
+            offset += c;
+        }
+        for(i = 0;i < n;i++) {
+            unsigned key = from[i] ^ 0x80000000u;
+            to[count[(key >> shift) & (RADIX_BUCKETS-1)]++] = from[i];
+        }
+        tmp = from;
+        from = to;
+        to = tmp;
     }
+    if(from != (unsigned*)rs->array->vals) memcpy(rs->array->vals, from, sizeof(int)*n);
+}
+void radix_sort_array(struct array *array) {
+    struct radix_sort rs;
+    rs.array = array;
+    rs.scratch = malloc(sizeof(int)*array->sz);
+    radix_sort(&rs);
+    free(rs.scratch);
+}
 
-    /* O(1) */
-    environment = &(environments[i++]);
-    environment->n = array->sz;
-    environment->algo = (func)&get_first;
-    environment->data = array;
-    environment->oclass = O1;
-    /* O(log(n)) */
-    environment = &(environments[i++]);
-    environment->n = search->haystack->sz;
-    environment->algo = (func)&binary_jump_search;
-    environment->data = search;
-    environment->oclass = O_logn;
-    /* O(sqrt(n)) */
-    environment = &(environments[i++]);
-    environment->n = rs->array->sz;
-    environment->algo = (func)&range_sum_query;
-    environment->data = rs;
-    environment->oclass = O_sqrtn;
-    /* O(n) */
-    environment = &(environments[i++]);
-    environment->n = search->haystack->sz;
-    environment->algo = (func)&linear_search;
-    environment->data = search;
-    environment->oclass = O_n;
-    /* O(nlog(n)) */
-    environment = &(environments[i++]);
-    environment->n = mutable_array->sz;
-    environment->algo = (func)&quick_sort;
-    environment->data = mutable_array;
-    environment->oclass = O_nlogn;
-    /* O(n^2) */
-    environment = &(environments[i++]);
-    environment->n = array->sz;
-    environment->algo = (func)&find_max_seq_sum;
-    environment->data = array;
-    environment->oclass = O_n_power_2;
-    /* O(2^n) */
-    environment = &(environments[i++]);
-    environment->n = sz;
-    environment->algo = (func)&solve_hanoi;
-    environment->data = (void*)sz;
-    environment->oclass = O_2_power_n;
-    /* O(n!) */
-    environment = &(environments[i++]);
-    environment->n = sz;
-    environment->algo = (func)do_nothing;
-    environment->data = NULL;
-    environment->oclass = O_n_permut;
-    /* O(n^n) */
-    environment = &(environments[i++]);
-    environment->n = sz;
-    environment->algo = (func)do_nothing;
-    environment->data = NULL;
-    environment->oclass = O_n_power_n;
+/* [=] Binary search with no
+ * data dependent branch: the
+ * compiler turns the step into
+ * a conditional move, and both
+ * possible next midpoints are
+ * prefetched.
+ */
+void branchless_search(struct search *s) {
+    int *base = s->haystack->vals;
+    long n = s->haystack->sz;
 
+    while(n > 1) {
+        long half = n / 2;
+        __builtin_prefetch(base + half/2);
+        __builtin_prefetch(base + half + half/2);
+        base = (base[half] <= s->needle) ? base + half : base;
+        n -= half;
+    }
+    if(s->haystack->sz > 0 && *base == s->needle) RESULT(FOUND);
+    else RESULT(NOT_FOUND);
+}
 
-    /* - end marker */
-    environment = &(environments[i++]);
-    environment->algo = NULL;
+/* The sorted haystack laid out
+ * as an implicit tree in BFS
+ * order (1-indexed: the children
+ * of `k` are `2k` and `2k+1`).
+ * The top levels of the tree
+ * then share the same few cache
+ * lines.
+ */
+struct eytzinger {
+    int needle;
+    long sz;
+    int *vals;
+};
+/* How far down the tree to
+ * prefetch: 2 = grandchildren
+ * (which are adjacent in
+ * memory).
+ */
+#define EYTZINGER_PREFETCH_LEVELS 2
+/* [=] Fill the tree in-order
+ * from the sorted values
+ */
+long eytzinger_build_1(int *sorted, int *vals, long i, long k, long sz) {
+    if(k <= sz) {
+        i = eytzinger_build_1(sorted, vals, i, 2*k, sz);
+        vals[k] = sorted[i++];
+        i = eytzinger_build_1(sorted, vals, i, 2*k + 1, sz);
+    }
+    return i;
+}
+struct eytzinger* eytzinger_build(struct search *s) {
+    struct eytzinger *e = arena_alloc(sizeof(struct eytzinger));
+    e->needle = s->needle;
+    e->sz = s->haystack->sz;
+    e->vals = arena_alloc(sizeof(int)*(e->sz + 1));
+    eytzinger_build_1(s->haystack->vals, e->vals, 0, 1, e->sz);
+    return e;
+}
+/* [=] Walk down the tree without
+ * branching then undo the
+ * trailing right turns to land
+ * on the first value >= needle
+ */
+void eytzinger_search(struct eytzinger *e) {
+    unsigned long k = 1;
 
-    return environments;
+    while(k <= (unsigned long)e->sz) {
+        __builtin_prefetch(e->vals + (k << EYTZINGER_PREFETCH_LEVELS));
+        k = 2*k + (e->vals[k] < e->needle);
+    }
+    k >>= __builtin_ffsl(~k);
+    if(k && e->vals[k] == e->needle) RESULT(FOUND);
+    else RESULT(NOT_FOUND);
 }
 
-long get_sz(int argc, char* argv[]) {
-    if(argc < 2) return 0;
-    return atol(argv[1]);
+/* [=] Index of the first match
+ * or -1 - the plain scalar
+ * loop
+ */
+long find_first_scalar(int *vals, long n, int needle) {
+    long i;
+    for(i = 0;i < n;i++) if(vals[i] == needle) return i;
+    return -1;
 }
+#if defined(__x86_64__) || defined(__i386__)
+/* [=] Compare 16 ints per step
+ * (4 vectors OR-ed together so
+ * the loop has one branch) and
+ * only look for the lane once
+ * something matched.
+ */
+__attribute__((target("sse2")))
+long find_first_sse2(int *vals, long n, int needle) {
+    __m128i key = _mm_set1_epi32(needle);
+    long i = 0;
 
-int main(int argc, char* argv[]) {
-    long sz = get_sz(argc, argv);
-    if(!sz) printf("Usage: %s <number of items>\n", argv[0]);
-    else show_algo_results(create_environments(sz));
+    for(;i + 16 <= n;i += 16) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i*)(vals+i)), key);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i*)(vals+i+4)), key);
+        __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i*)(vals+i+8)), key);
+        __m128i d = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i*)(vals+i+12)), key);
+        if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)))) {
+            unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(a))
+                | _mm_movemask_ps(_mm_castsi128_ps(b)) << 4
+                | _mm_movemask_ps(_mm_castsi128_ps(c)) << 8
+                | _mm_movemask_ps(_mm_castsi128_ps(d)) << 12;
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for(;i < n;i++) if(vals[i] == needle) return i;
+    return -1;
+}
+__attribute__((target("avx2")))
+long find_first_avx2(int *vals, long n, int needle) {
+    __m256i key = _mm256_set1_epi32(needle);
+    long i = 0;
+
+    for(;i + 32 <= n;i += 32) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i*)(vals+i)), key);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i*)(vals+i+8)), key);
+        __m256i c = _mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i*)(vals+i+16)), key);
+        __m256i d = _mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i*)(vals+i+24)), key);
+        if(!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))
+                || !_mm256_testz_si256(_mm256_or_si256(c, d), _mm256_or_si256(c, d))) {
+            unsigned long long mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a))
+                | (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8
+                | (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(c)) << 16
+                | (unsigned long long)_mm256_movemask_ps(_mm256_castsi256_ps(d)) << 24;
+            return i + __builtin_ctzll(mask);
+        }
+    }
+    for(;i < n;i++) if(vals[i] == needle) return i;
+    return -1;
+}
+__attribute__((target("avx512f")))
+long find_first_avx512(int *vals, long n, int needle) {
+    __m512i key = _mm512_set1_epi32(needle);
+    long i = 0;
+
+    for(;i + 64 <= n;i += 64) {
+        unsigned long long mask =
+            (unsigned long long)_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(vals+i), key)
+            | (unsigned long long)_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(vals+i+16), key) << 16
+            | (unsigned long long)_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(vals+i+32), key) << 32
+            | (unsigned long long)_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(vals+i+48), key) << 48;
+        if(mask) return i + __builtin_ctzll(mask);
+    }
+    /* the tail is masked rather
+     * than scalar */
+    for(;i < n;i += 16) {
+        __mmask16 live = n - i >= 16 ? 0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(live, _mm512_maskz_loadu_epi32(live, vals+i), key);
+        if(mask) return i + __builtin_ctz(mask);
+    }
+    return -1;
+}
+#endif
+#if defined(__aarch64__)
+long find_first_neon(int *vals, long n, int needle) {
+    int32x4_t key = vdupq_n_s32(needle);
+    long i = 0;
+
+    for(;i + 16 <= n;i += 16) {
+        uint32x4_t a = vceqq_s32(vld1q_s32(vals+i), key);
+        uint32x4_t b = vceqq_s32(vld1q_s32(vals+i+4), key);
+        uint32x4_t c = vceqq_s32(vld1q_s32(vals+i+8), key);
+        uint32x4_t d = vceqq_s32(vld1q_s32(vals+i+12), key);
+        if(vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d)))) break;
+    }
+    for(;i < n;i++) if(vals[i] == needle) return i;
+    return -1;
+}
+#endif
+
+/* The widest vector kernel the
+ * CPU we are running on has.
+ */
+struct find_first_engine {
+    char *name;
+    long (*find)(int *vals, long n, int needle);
+};
+struct find_first_engine select_find_first(void) {
+    struct find_first_engine engine = { "simd_search_scalar", &find_first_scalar };
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) {
+        engine.name = "simd_search_avx512";
+        engine.find = &find_first_avx512;
+    } else if(__builtin_cpu_supports("avx2")) {
+        engine.name = "simd_search_avx2";
+        engine.find = &find_first_avx2;
+    } else if(__builtin_cpu_supports("sse2")) {
+        engine.name = "simd_search_sse2";
+        engine.find = &find_first_sse2;
+    }
+#elif defined(__aarch64__)
+    engine.name = "simd_search_neon";
+    engine.find = &find_first_neon;
+#endif
+    return engine;
+}
+static struct find_first_engine find_first_engine;
+
+/* [=] linear_search on the
+ * vector kernel picked at start
+ * up - the result is the index
+ * of the first match (or -1)
+ */
+void simd_linear_search(struct search *s) {
+    RESULT(find_first_engine.find(s->haystack->vals, s->haystack->sz, s->needle));
+}
+/* [=] The same on the plain
+ * loop, to check it against
+ */
+void scalar_linear_search(struct search *s) {
+    RESULT(find_first_scalar(s->haystack->vals, s->haystack->sz, s->needle));
+}
+
+/* A batch of needles to look
+ * up in one haystack. The
+ * scratch space is allocated
+ * with the batch so the engines
+ * never allocate.
+ */
+struct batch_search {
+    long num;
+    int *needles;
+    struct array *haystack;
+    long found;
+    int *sorted_needles;
+    long set_sz;
+    int *set_keys;
+    long *set_counts;
+    unsigned char *set_state;
+};
+/* Binary searches in flight at
+ * once - enough to hide the
+ * latency of a cache miss.
+ */
+#define BATCH_GROUP 16
+/* Sorting the needles only pays
+ * off once there are enough of
+ * them to share cache lines.
+ */
+#define BATCH_SORT_MIN 256
+
+struct batch_search* create_batch_search(struct array *haystack, long num, struct rng *rng) {
+    struct batch_search *b = arena_alloc(sizeof(struct batch_search));
+    long i;
+
+    b->num = num;
+    b->haystack = haystack;
+    b->needles = arena_alloc(sizeof(int)*num);
+    /* half the needles are in the
+     * haystack, half most likely
+     * are not */
+    for(i = 0;i < num;i++) {
+        b->needles[i] = i % 2 ? rng_int(rng) : haystack->vals[rng_below(rng, haystack->sz)];
+    }
+    b->sorted_needles = arena_alloc(sizeof(int)*num);
+    for(b->set_sz = 1;b->set_sz < 2*num;b->set_sz *= 2);
+    b->set_keys = arena_alloc(sizeof(int)*b->set_sz);
+    b->set_counts = arena_alloc(sizeof(long)*b->set_sz);
+    b->set_state = arena_alloc(b->set_sz);
+    return b;
+}
+
+/* [=] The baseline: one
+ * binary_jump_search per needle
+ */
+void batch_binary_loop(struct batch_search *b) {
+    struct search s;
+    long i, found = 0;
+
+    s.haystack = b->haystack;
+    for(i = 0;i < b->num;i++) {
+        s.needle = b->needles[i];
+        binary_jump_search(&s);
+        found += bench_result == FOUND;
+    }
+    b->found = found;
+    RESULT(found);
 }
+/* [=] Branchless binary searches
+ * for a group of needles run in
+ * lock step - while one level of
+ * the group is compared the next
+ * level is being prefetched - so
+ * the cache misses overlap.
+ */
+void batch_binary_search(struct batch_search *b) {
+    int *vals = b->haystack->vals;
+    int *needles = b->needles;
+    long start, found = 0;
 
+    if(b->haystack->sz == 0) {
+        b->found = 0;
+        return;
+    }
+    if(b->num >= BATCH_SORT_MIN) {
+        struct array sorted;
+        memcpy(b->sorted_needles, b->needles, sizeof(int)*b->num);
+        sorted.sz = b->num;
+        sorted.vals = b->sorted_needles;
+        intro_sort(&sorted);
+        needles = b->sorted_needles;
+    }
+
+    for(start = 0;start < b->num;start += BATCH_GROUP) {
+        int *base[BATCH_GROUP];
+        long cnt = b->num - start < BATCH_GROUP ? b->num - start : BATCH_GROUP;
+        long n = b->haystack->sz;
+        long g;
+
+        for(g = 0;g < cnt;g++) base[g] = vals;
+        while(n > 1) {
+            long half = n / 2;
+            for(g = 0;g < cnt;g++) {
+                __builtin_prefetch(base[g] + half/2);
+                __builtin_prefetch(base[g] + half + half/2);
+            }
+            for(g = 0;g < cnt;g++) {
+                base[g] = (base[g][half] <= needles[start+g]) ? base[g] + half : base[g];
+            }
+            n -= half;
+        }
+        for(g = 0;g < cnt;g++) found += (*base[g] == needles[start+g]);
+    }
+    b->found = found;
+    RESULT(found);
+}
+
+/* [=] The baseline: one
+ * linear_search per needle
+ */
+void batch_linear_loop(struct batch_search *b) {
+    struct search s;
+    long i, found = 0;
+
+    s.haystack = b->haystack;
+    for(i = 0;i < b->num && !CANCELLED();i++) {
+        s.needle = b->needles[i];
+        linear_search(&s);
+        found += bench_result == FOUND;
+    }
+    b->found = found;
+    RESULT(found);
+}
+long batch_set_slot_1(struct batch_search *b, int key) {
+    long slot = ((unsigned)key * 0x9E3779B1u) & (b->set_sz - 1);
+    while(b->set_state[slot] && b->set_keys[slot] != key) slot = (slot + 1) & (b->set_sz - 1);
+    return slot;
+}
+/* [=] Put the needles into a
+ * small hash set and scan the
+ * haystack _once_ for all of
+ * them - stopping as soon as
+ * every needle is found.
+ */
+void batch_linear_search(struct batch_search *b) {
+    int *vals = b->haystack->vals;
+    long i, unique = 0, found = 0;
+
+    memset(b->set_state, 0, b->set_sz);
+    for(i = 0;i < b->num;i++) {
+        long slot = batch_set_slot_1(b, b->needles[i]);
+        if(!b->set_state[slot]) {
+            b->set_state[slot] = 1;
+            b->set_keys[slot] = b->needles[i];
+            b->set_counts[slot] = 0;
+            unique++;
+        }
+        b->set_counts[slot]++;
+    }
+    for(i = 0;i < b->haystack->sz && unique > 0;i++) {
+        long slot = batch_set_slot_1(b, vals[i]);
+        if(b->set_state[slot] == 1) {
+            b->set_state[slot] = 2;
+            found += b->set_counts[slot];
+            unique--;
+        }
+    }
+    b->found = found;
+    RESULT(found);
+}
+
+/* The O(n) engines for the max
+ * sequential sum. Unlike
+ * find_max_seq_sum they add in
+ * exact 64 bit integers.
+ */
+struct max_seq {
+    struct array *array;
+    long long best;
+};
+/* [=] Kadane: the best sum
+ * ending here is either the
+ * best ending just before plus
+ * this item - or nothing.
+ */
+void kadane_max_seq_sum(struct max_seq *ms) {
+    long long best = 0, curr = 0;
+    long i;
+
+    for(i = 0;i < ms->array->sz;i++) {
+        curr += ms->array->vals[i];
+        if(curr < 0) curr = 0;
+        if(curr > best) best = curr;
+    }
+    ms->best = best;
+    RESULT(best);
+}
+
+/* What a chunk contributes to
+ * the max sum over a larger
+ * range (each may be empty):
+ * its best prefix, best suffix,
+ * total, and best sum inside.
+ */
+struct seq_sums {
+    long long prefix;
+    long long suffix;
+    long long total;
+    long long best;
+};
+#define MAX_1(a,b) ((a) > (b) ? (a) : (b))
+struct seq_sums merge_seq_sums(struct seq_sums a, struct seq_sums b) {
+    struct seq_sums m;
+    m.total = a.total + b.total;
+    m.prefix = MAX_1(a.prefix, a.total + b.prefix);
+    m.suffix = MAX_1(b.suffix, b.total + a.suffix);
+    m.best = MAX_1(MAX_1(a.best, b.best), a.suffix + b.prefix);
+    return m;
+}
+/* [=] One pass of prefix sums:
+ * the best sum ending at `i` is
+ * P[i] - min(P[0..i])
+ */
+struct seq_sums seq_sums_1(int *vals, long n) {
+    struct seq_sums s;
+    long long p = 0, min_p = 0, max_p = 0, best = 0;
+    long i;
+
+    for(i = 0;i < n;i++) {
+        p += vals[i];
+        if(p - min_p > best) best = p - min_p;
+        if(p < min_p) min_p = p;
+        if(p > max_p) max_p = p;
+    }
+    s.total = p;
+    s.prefix = max_p;
+    s.suffix = p - min_p;
+    s.best = best;
+    return s;
+}
+
+/* The vector engine runs the
+ * prefix sum pass over 4 chunks
+ * at once - one per 64 bit lane.
+ */
+#define SEQ_LANES 4
+void seq_lanes_scalar(int *vals, long len, struct seq_sums *lanes) {
+    int k;
+    for(k = 0;k < SEQ_LANES;k++) lanes[k] = seq_sums_1(vals + k*len, len);
+}
+#if defined(__x86_64__) || defined(__i386__)
+#define SEQ_MAX_EPI64(a,b) _mm256_blendv_epi8((b), (a), _mm256_cmpgt_epi64((a), (b)))
+#define SEQ_MIN_EPI64(a,b) _mm256_blendv_epi8((a), (b), _mm256_cmpgt_epi64((a), (b)))
+#define SEQ_STEP(r) do { \
+        p = _mm256_add_epi64(p, _mm256_cvtepi32_epi64(r)); \
+        best = SEQ_MAX_EPI64(best, _mm256_sub_epi64(p, min_p)); \
+        min_p = SEQ_MIN_EPI64(min_p, p); \
+        max_p = SEQ_MAX_EPI64(max_p, p); \
+    } while(0)
+/* [=] Load 4 items from each
+ * chunk, transpose them so each
+ * vector holds the next item of
+ * every chunk, and step all 4
+ * prefix sums together.
+ */
+__attribute__((target("avx2")))
+void seq_lanes_avx2(int *vals, long len, struct seq_sums *lanes) {
+    __m256i p = _mm256_setzero_si256(), min_p = p, max_p = p, best = p;
+    long long ps[SEQ_LANES], min_ps[SEQ_LANES], max_ps[SEQ_LANES], bests[SEQ_LANES];
+    long i = 0;
+    int k;
+
+    for(;i + 4 <= len;i += 4) {
+        __m128i a = _mm_loadu_si128((__m128i*)(vals + i));
+        __m128i b = _mm_loadu_si128((__m128i*)(vals + len + i));
+        __m128i c = _mm_loadu_si128((__m128i*)(vals + 2*len + i));
+        __m128i d = _mm_loadu_si128((__m128i*)(vals + 3*len + i));
+        __m128i ab_lo = _mm_unpacklo_epi32(a, b), cd_lo = _mm_unpacklo_epi32(c, d);
+        __m128i ab_hi = _mm_unpackhi_epi32(a, b), cd_hi = _mm_unpackhi_epi32(c, d);
+        SEQ_STEP(_mm_unpacklo_epi64(ab_lo, cd_lo));
+        SEQ_STEP(_mm_unpackhi_epi64(ab_lo, cd_lo));
+        SEQ_STEP(_mm_unpacklo_epi64(ab_hi, cd_hi));
+        SEQ_STEP(_mm_unpackhi_epi64(ab_hi, cd_hi));
+    }
+    _mm256_storeu_si256((__m256i*)ps, p);
+    _mm256_storeu_si256((__m256i*)min_ps, min_p);
+    _mm256_storeu_si256((__m256i*)max_ps, max_p);
+    _mm256_storeu_si256((__m256i*)bests, best);
+
+    /* finish the last few items of
+     * each chunk one at a time */
+    for(k = 0;k < SEQ_LANES;k++) {
+        long j;
+        for(j = i;j < len;j++) {
+            ps[k] += vals[k*len + j];
+            if(ps[k] - min_ps[k] > bests[k]) bests[k] = ps[k] - min_ps[k];
+            if(ps[k] < min_ps[k]) min_ps[k] = ps[k];
+            if(ps[k] > max_ps[k]) max_ps[k] = ps[k];
+        }
+        lanes[k].total = ps[k];
+        lanes[k].prefix = max_ps[k];
+        lanes[k].suffix = ps[k] - min_ps[k];
+        lanes[k].best = bests[k];
+    }
+}
+#endif
+static void (*seq_lanes)(int *vals, long len, struct seq_sums *lanes) = &seq_lanes_scalar;
+void select_seq_lanes(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) seq_lanes = &seq_lanes_avx2;
+#endif
+}
+void simd_max_seq_sum(struct max_seq *ms) {
+    long len = ms->array->sz / SEQ_LANES;
+    struct seq_sums lanes[SEQ_LANES], s;
+    int k;
+
+    seq_lanes(ms->array->vals, len, lanes);
+
+    /* merge the lanes in order and
+     * the left over tail last */
+    s = seq_sums_1(ms->array->vals + SEQ_LANES*len, ms->array->sz - SEQ_LANES*len);
+    for(k = SEQ_LANES - 1;k >= 0;k--) s = merge_seq_sums(lanes[k], s);
+    ms->best = s.best;
+    RESULT(s.best);
+}
+
+/* Chunks per thread - a few so
+ * a slow thread can be helped
+ * by the others.
+ */
+#define SEQ_CHUNKS_PER_THREAD 4
+struct seq_chunk {
+    int *vals;
+    long n;
+    struct seq_sums sums;
+};
+void seq_chunk_1(struct task *task) {
+    struct seq_chunk *chunk = (struct seq_chunk*)task->data + task->low;
+    chunk->sums = seq_sums_1(chunk->vals, chunk->n);
+}
+/* [=] Each chunk is summed on
+ * the pool then the tuples are
+ * merged left to right.
+ */
+void parallel_max_seq_sum(struct max_seq *ms) {
+    long num = (long)bench_pool->num_threads * SEQ_CHUNKS_PER_THREAD;
+    long len = ms->array->sz / num + 1;
+    struct seq_chunk chunks[num];
+    struct seq_sums s = { 0, 0, 0, 0 };
+    atomic_long pending;
+    struct task task;
+    long c;
+
+    atomic_init(&pending, 0);
+    task.run = &seq_chunk_1;
+    task.data = chunks;
+    task.pending = &pending;
+    for(c = 0;c < num;c++) {
+        long from = c * len < ms->array->sz ? c * len : ms->array->sz;
+        long to = from + len < ms->array->sz ? from + len : ms->array->sz;
+        chunks[c].vals = ms->array->vals + from;
+        chunks[c].n = to - from;
+        task.low = c;
+        pool_submit(bench_pool, &task);
+    }
+    pool_wait(bench_pool, &pending);
+
+    for(c = 0;c < num;c++) s = merge_seq_sums(s, chunks[c].sums);
+    ms->best = s.best;
+    RESULT(s.best);
+}
+
+/* [=] All the O(n) engines must
+ * agree on the answer
+ */
+int check_max_seq_sums(struct max_seq *ms) {
+    long long kadane, simd, parallel;
+
+    kadane_max_seq_sum(ms);
+    kadane = ms->best;
+    simd_max_seq_sum(ms);
+    simd = ms->best;
+    parallel_max_seq_sum(ms);
+    parallel = ms->best;
+    if(kadane == simd && kadane == parallel) return 1;
+
+    fprintf(stderr, "max seq sum engines disagree: kadane %lld simd %lld parallel %lld\n",
+            kadane, simd, parallel);
+    return 0;
+}
+
+/* [=] Sum of `n` ints - the
+ * plain loop
+ */
+long long sum_ints_scalar(int *vals, long n) {
+    long long sum = 0;
+    long i;
+    for(i = 0;i < n;i++) sum += vals[i];
+    return sum;
+}
+long long sum_longs_scalar(long *vals, long n) {
+    long long sum = 0;
+    long i;
+    for(i = 0;i < n;i++) sum += vals[i];
+    return sum;
+}
+#if defined(__x86_64__) || defined(__i386__)
+/* [=] Widen 8 ints at a time to
+ * 64 bits and add them in two
+ * accumulators
+ */
+__attribute__((target("avx2")))
+long long sum_ints_avx2(int *vals, long n) {
+    __m256i a = _mm256_setzero_si256(), b = a;
+    long long lanes[4], sum;
+    long i = 0;
+
+    for(;i + 8 <= n;i += 8) {
+        __m256i x = _mm256_loadu_si256((__m256i*)(vals + i));
+        a = _mm256_add_epi64(a, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+        b = _mm256_add_epi64(b, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(a, b));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(;i < n;i++) sum += vals[i];
+    return sum;
+}
+__attribute__((target("avx2")))
+long long sum_longs_avx2(long *vals, long n) {
+    __m256i a = _mm256_setzero_si256();
+    long long lanes[4], sum;
+    long i = 0;
+
+    for(;i + 4 <= n;i += 4) a = _mm256_add_epi64(a, _mm256_loadu_si256((__m256i*)(vals + i)));
+    _mm256_storeu_si256((__m256i*)lanes, a);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(;i < n;i++) sum += vals[i];
+    return sum;
+}
+#endif
+static long long (*sum_ints)(int *vals, long n) = &sum_ints_scalar;
+static long long (*sum_longs)(long *vals, long n) = &sum_longs_scalar;
+void select_sums(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        sum_ints = &sum_ints_avx2;
+        sum_longs = &sum_longs_avx2;
+    }
+#endif
+}
+
+/* Items each thread sums at a
+ * time when building the slices.
+ */
+#define SLICE_SUMS_GRAIN (1L << 16)
+void slice_sums_1(struct task *task) {
+    struct range_sum *rs = task->data;
+    long slice;
+
+    for(slice = task->low;slice < task->high;slice++) {
+        long from = slice*rs->root_sz;
+        long to = from + rs->root_sz < rs->array->sz ? from + rs->root_sz : rs->array->sz;
+        rs->slice_sum[slice] = from < to ? sum_ints(rs->array->vals + from, to - from) : 0;
+    }
+}
+/* [=] (Re)fill the slice sums
+ * on all threads */
+void build_slice_sums(struct range_sum *rs) {
+    long num_slices = rs->array->sz/rs->root_sz + 1;
+    long per_task = SLICE_SUMS_GRAIN / rs->root_sz + 1;
+    long slice;
+    atomic_long pending;
+    struct task task;
+
+    atomic_init(&pending, 0);
+    task.run = &slice_sums_1;
+    task.data = rs;
+    task.pending = &pending;
+    for(slice = 0;slice < num_slices;slice += per_task) {
+        task.low = slice;
+        task.high = slice + per_task < num_slices ? slice + per_task : num_slices;
+        pool_submit(bench_pool, &task);
+    }
+    pool_wait(bench_pool, &pending);
+}
+/* [=] Build the slices for any
+ * slice size (0 = sqrt(n)) with
+ * each thread vector summing
+ * whole slices - no divide per
+ * item
+ */
+void parallel_setup_slice_sums(struct range_sum* rs, long slice_sz) {
+    rs->root_sz = slice_sz > 0 ? slice_sz : (long)sqrt(rs->array->sz);
+    if(rs->root_sz < 1) rs->root_sz = 1;
+    rs->slice_sum = arena_alloc(sizeof(long)*(rs->array->sz/rs->root_sz + 1));
+    build_slice_sums(rs);
+}
+/* [=] The build on its own (to
+ * compare with offloading it) */
+void slice_sums_build(struct range_sum *rs) {
+    build_slice_sums(rs);
+    RESULT(sum_longs(rs->slice_sum, rs->array->sz/rs->root_sz + 1));
+}
+
+/* A stream of range sum queries
+ * mixed with point updates. Every
+ * range sum engine runs the same
+ * stream on its own copy of the
+ * array.
+ */
+struct range_op {
+    int update;
+    long from;
+    long to;
+    int val;
+};
+struct range_ops {
+    long num;
+    struct range_op *ops;
+};
+struct range_stream {
+    struct range_ops *ops;
+    void *engine;
+    long long checksum;
+};
+
+/* [=] `num` random ops of which
+ * `updates` percent set an item
+ */
+struct range_ops* create_range_ops(long sz, long num, int updates, struct rng *rng) {
+    struct range_ops *ops = arena_alloc(sizeof(struct range_ops));
+    long i;
+
+    ops->num = num;
+    ops->ops = arena_alloc(sizeof(struct range_op)*num);
+    for(i = 0;i < num;i++) {
+        struct range_op *op = &ops->ops[i];
+        long a = rng_below(rng, sz), b = rng_below(rng, sz);
+        op->update = rng_below(rng, 100) < updates;
+        op->from = a < b ? a : b;
+        op->to = a < b ? b : a;
+        op->val = rng_int(rng);
+    }
+    return ops;
+}
+struct array* clone_array(struct array *array) {
+    struct array *clone = arena_alloc(sizeof(struct array));
+    clone->sz = array->sz;
+    clone->vals = arena_alloc(sizeof(int)*array->sz);
+    memcpy(clone->vals, array->vals, sizeof(int)*array->sz);
+    return clone;
+}
+
+/* [=] The O(sqrt(n)) engine:
+ * range_sum_1 over the slices
+ */
+struct range_stream* create_sqrt_stream(struct array *array, struct range_ops *ops, long slice_sz) {
+    struct range_stream *stream = arena_alloc(sizeof(struct range_stream));
+    struct range_sum *rs = arena_alloc(sizeof(struct range_sum));
+
+    rs->array = clone_array(array);
+    parallel_setup_slice_sums(rs, slice_sz);
+    stream->ops = ops;
+    stream->engine = rs;
+    return stream;
+}
+void sqrt_range_stream(struct range_stream *stream) {
+    struct range_sum *rs = stream->engine;
+    long long checksum = 0;
+    long i;
+
+    for(i = 0;i < stream->ops->num;i++) {
+        struct range_op *op = &stream->ops->ops[i];
+        if(op->update) range_sum_update(rs, op->from, op->val);
+        else checksum += range_sum_1(rs, op->from, op->to);
+    }
+    stream->checksum = checksum;
+    RESULT(checksum);
+}
+
+/* A Fenwick (binary indexed)
+ * tree: tree[i] holds the sum of
+ * the `i & -i` items ending at
+ * `i` (1-indexed), so both a
+ * prefix sum and an update touch
+ * only log(n) entries.
+ */
+struct fenwick {
+    struct array *array;
+    long long *tree;
+};
+long long fenwick_prefix_1(struct fenwick *f, long end) {
+    long long sum = 0;
+    for(;end > 0;end -= end & -end) sum += f->tree[end];
+    return sum;
+}
+void fenwick_update_1(struct fenwick *f, long idx, int val) {
+    long long delta = (long long)val - f->array->vals[idx];
+    long i;
+
+    f->array->vals[idx] = val;
+    for(i = idx + 1;i <= f->array->sz;i += i & -i) f->tree[i] += delta;
+}
+/* [=] Build in O(n) by pushing
+ * each partial sum up to its
+ * parent
+ */
+struct range_stream* create_fenwick_stream(struct array *array, struct range_ops *ops) {
+    struct range_stream *stream = arena_alloc(sizeof(struct range_stream));
+    struct fenwick *f = arena_alloc(sizeof(struct fenwick));
+    long i;
+
+    f->array = clone_array(array);
+    f->tree = arena_alloc(sizeof(long long)*(array->sz + 1));
+    for(i = 1;i <= array->sz;i++) {
+        long parent = i + (i & -i);
+        f->tree[i] += f->array->vals[i-1];
+        if(parent <= array->sz) f->tree[parent] += f->tree[i];
+    }
+    stream->ops = ops;
+    stream->engine = f;
+    return stream;
+}
+void fenwick_range_stream(struct range_stream *stream) {
+    struct fenwick *f = stream->engine;
+    long long checksum = 0;
+    long i;
+
+    for(i = 0;i < stream->ops->num;i++) {
+        struct range_op *op = &stream->ops->ops[i];
+        if(op->update) fenwick_update_1(f, op->from, op->val);
+        else checksum += fenwick_prefix_1(f, op->to + 1) - fenwick_prefix_1(f, op->from);
+    }
+    stream->checksum = checksum;
+    RESULT(checksum);
+}
+
+/* A disjoint sparse table: at
+ * level `h` the array is cut
+ * into blocks of 2^h and each
+ * entry holds the sum from the
+ * middle of its block out to
+ * it. Any range is then the sum
+ * of just two entries: O(1)
+ * queries - but an update has
+ * to fix up O(n) entries and
+ * the table needs O(n log(n))
+ * memory, so it is only built
+ * for smaller arrays.
+ */
+#define SPARSE_TABLE_MAX (1L << 20)
+struct sparse_table {
+    struct array *array;
+    int levels;
+    long sz;
+    long long *table;
+};
+void sparse_build_level_1(struct sparse_table *st, int h) {
+    long long *row = st->table + (long)h * st->sz;
+    long half = 1L << (h - 1);
+    long start, j;
+
+    for(start = 0;start < st->sz;start += 2*half) {
+        long mid = start + half;
+        long long sum = 0;
+        for(j = mid - 1;j >= start;j--) {
+            if(j < st->array->sz) sum += st->array->vals[j];
+            row[j] = sum;
+        }
+        sum = 0;
+        for(j = mid;j < start + 2*half;j++) {
+            if(j < st->array->sz) sum += st->array->vals[j];
+            row[j] = sum;
+        }
+    }
+}
+long long sparse_query_1(struct sparse_table *st, long from, long to) {
+    int h;
+    if(from == to) return st->array->vals[from];
+    h = 64 - __builtin_clzl(from ^ to);
+    return st->table[(long)h * st->sz + from] + st->table[(long)h * st->sz + to];
+}
+/* [=] Add the change to every
+ * entry whose sum covers `idx`:
+ * the entries between it and
+ * the middle of its block, on
+ * every level.
+ */
+void sparse_update_1(struct sparse_table *st, long idx, int val) {
+    long long delta = (long long)val - st->array->vals[idx];
+    int h;
+
+    st->array->vals[idx] = val;
+    for(h = 1;h <= st->levels;h++) {
+        long long *row = st->table + (long)h * st->sz;
+        long half = 1L << (h - 1);
+        long start = idx & ~(2*half - 1);
+        long mid = start + half;
+        long j;
+
+        if(idx < mid) for(j = start;j <= idx;j++) row[j] += delta;
+        else for(j = idx;j < start + 2*half;j++) row[j] += delta;
+    }
+}
+struct range_stream* create_sparse_stream(struct array *array, struct range_ops *ops) {
+    struct range_stream *stream;
+    struct sparse_table *st;
+    int h;
+
+    if(array->sz > SPARSE_TABLE_MAX) return NULL;
+
+    stream = arena_alloc(sizeof(struct range_stream));
+    st = arena_alloc(sizeof(struct sparse_table));
+    st->array = clone_array(array);
+    for(st->levels = 0, st->sz = 1;st->sz < array->sz;st->levels++) st->sz *= 2;
+    st->table = arena_alloc(sizeof(long long) * st->sz * (st->levels + 1));
+    for(h = 1;h <= st->levels;h++) sparse_build_level_1(st, h);
+    stream->ops = ops;
+    stream->engine = st;
+    return stream;
+}
+void sparse_range_stream(struct range_stream *stream) {
+    struct sparse_table *st = stream->engine;
+    long long checksum = 0;
+    long i;
+
+    for(i = 0;i < stream->ops->num && !CANCELLED();i++) {
+        struct range_op *op = &stream->ops->ops[i];
+        if(op->update) sparse_update_1(st, op->from, op->val);
+        else checksum += sparse_query_1(st, op->from, op->to);
+    }
+    stream->checksum = checksum;
+    RESULT(checksum);
+}
+
+/* [=] Run the stream once on each
+ * engine - they must agree
+ */
+int check_range_streams(struct range_stream *sqrt, struct range_stream *fenwick, struct range_stream *sparse) {
+    sqrt_range_stream(sqrt);
+    fenwick_range_stream(fenwick);
+    if(sparse) sparse_range_stream(sparse);
+    if(sqrt->checksum == fenwick->checksum && (!sparse || sqrt->checksum == sparse->checksum)) return 1;
+
+    fprintf(stderr, "range sum engines disagree: sqrt %lld fenwick %lld sparse %lld\n",
+            sqrt->checksum, fenwick->checksum, sparse ? sparse->checksum : 0);
+    return 0;
+}
+
+/* A batch of read only range
+ * sums answered together. The
+ * queries are grouped by the
+ * slice they start in so nearby
+ * ranges run back to back.
+ */
+struct range_batch {
+    struct range_sum *rs;
+    struct range_ops *ops;
+    long num_slices;
+    long *slice_starts;
+    long *order;
+    long long *sums;
+    long long checksum;
+};
+/* Queries handed to a thread at
+ * a time.
+ */
+#define RANGE_BATCH_GRAIN 256
+
+struct range_batch* create_range_batch(struct range_sum *rs, struct range_ops *ops) {
+    struct range_batch *b = arena_alloc(sizeof(struct range_batch));
+    b->rs = rs;
+    b->ops = ops;
+    b->num_slices = rs->array->sz / rs->root_sz + 1;
+    b->slice_starts = arena_alloc(sizeof(long)*(b->num_slices + 1));
+    b->order = arena_alloc(sizeof(long)*ops->num);
+    b->sums = arena_alloc(sizeof(long long)*ops->num);
+    return b;
+}
+/* [=] The baseline: one
+ * range_sum_1 call per query
+ */
+void range_sum_loop(struct range_batch *b) {
+    long long checksum = 0;
+    long q;
+
+    for(q = 0;q < b->ops->num;q++) {
+        checksum += range_sum_1(b->rs, b->ops->ops[q].from, b->ops->ops[q].to);
+    }
+    b->checksum = checksum;
+    RESULT(checksum);
+}
+/* [=] One range: vector sums of
+ * the partial slices at either
+ * edge and of the whole slices
+ * between them
+ */
+long long range_batch_sum_1(struct range_sum *rs, long from, long to) {
+    int *vals = rs->array->vals;
+    long first = (from + rs->root_sz - 1) / rs->root_sz;
+    long last = (to + 1) / rs->root_sz;
+
+    if(first >= last) return sum_ints(vals + from, to - from + 1);
+    return sum_ints(vals + from, first*rs->root_sz - from)
+        + sum_longs(rs->slice_sum + first, last - first)
+        + sum_ints(vals + last*rs->root_sz, to + 1 - last*rs->root_sz);
+}
+void range_batch_1(struct task *task) {
+    struct range_batch *b = task->data;
+    long k;
+
+    for(k = task->low;k < task->high;k++) {
+        struct range_op *op = &b->ops->ops[b->order[k]];
+        b->sums[b->order[k]] = range_batch_sum_1(b->rs, op->from, op->to);
+    }
+}
+/* [=] Counting sort the queries
+ * by starting slice, then split
+ * them across the pool
+ */
+void range_batch_sums(struct range_batch *b) {
+    long num = b->ops->num;
+    long long checksum = 0;
+    atomic_long pending;
+    struct task task;
+    long q, s;
+
+    memset(b->slice_starts, 0, sizeof(long)*(b->num_slices + 1));
+    for(q = 0;q < num;q++) b->slice_starts[b->ops->ops[q].from / b->rs->root_sz + 1]++;
+    for(s = 0;s < b->num_slices;s++) b->slice_starts[s+1] += b->slice_starts[s];
+    for(q = 0;q < num;q++) b->order[b->slice_starts[b->ops->ops[q].from / b->rs->root_sz]++] = q;
+
+    atomic_init(&pending, 0);
+    task.run = &range_batch_1;
+    task.data = b;
+    task.pending = &pending;
+    for(q = 0;q < num;q += RANGE_BATCH_GRAIN) {
+        task.low = q;
+        task.high = q + RANGE_BATCH_GRAIN < num ? q + RANGE_BATCH_GRAIN : num;
+        pool_submit(bench_pool, &task);
+    }
+    pool_wait(bench_pool, &pending);
+
+    for(q = 0;q < num;q++) checksum += b->sums[q];
+    b->checksum = checksum;
+    RESULT(checksum);
+}
+int check_range_batch(struct range_batch *b) {
+    long long loop;
+
+    range_sum_loop(b);
+    loop = b->checksum;
+    range_batch_sums(b);
+    if(loop == b->checksum) return 1;
+
+    fprintf(stderr, "range batch disagrees: loop %lld batch %lld\n", loop, b->checksum);
+    return 0;
+}
+
+/* The largest tower the move
+ * index can describe.
+ */
+#define HANOI_MAX_DISKS 63
+/* [=] No recursion: move `m` (of
+ * 1..2^n-1) moves disk ctz(m),
+ * and where it goes from and to
+ * follow directly from the bits
+ * of `m` (the Gray code of the
+ * move). Flipping two pegs for
+ * odd towers makes every tower
+ * end up on the same peg as
+ * solve_hanoi.
+ */
+void gray_code_hanoi(struct hanoi *hanoi) {
+    unsigned long long m, last;
+    unsigned long long checksum = 0;
+    int num = hanoi->num;
+    unsigned char pegs[3];
+    long count = 0;
+
+    if(num < 1 || num > HANOI_MAX_DISKS) return;
+    last = (1ULL << num) - 1;
+    pegs[0] = 1;
+    pegs[1] = num % 2 ? 3 : 2;
+    pegs[2] = num % 2 ? 2 : 3;
+
+    for(m = 1;m <= last;m++) {
+        unsigned disk = __builtin_ctzll(m);
+        if(!(m & 0xFFFF) && CANCELLED()) break;
+        unsigned from_peg = pegs[(m & (m - 1)) % 3];
+        unsigned to_peg = pegs[((m | (m - 1)) + 1) % 3];
+
+        if(!hanoi->moves) {
+            checksum += disk ^ (from_peg << 6) ^ (to_peg << 8);
+            continue;
+        }
+        hanoi->moves[count].disk = disk;
+        hanoi->moves[count].from_peg = from_peg;
+        hanoi->moves[count].to_peg = to_peg;
+        if(++count == hanoi->max_moves) {
+            if(hanoi->flush) hanoi->flush(hanoi, count);
+            count = 0;
+        }
+    }
+    if(count && hanoi->flush) hanoi->flush(hanoi, count);
+    hanoi->checksum = checksum;
+    RESULT(checksum);
+}
+/* Moves per flush when the
+ * benchmark writes them out.
+ */
+#define HANOI_BATCH 4096
+struct hanoi* create_hanoi(long num, long max_moves) {
+    struct hanoi *hanoi = arena_alloc(sizeof(struct hanoi));
+    hanoi->num = num;
+    hanoi->max_moves = max_moves;
+    hanoi->moves = max_moves ? arena_alloc(sizeof(struct hanoi_move)*max_moves) : NULL;
+    hanoi->flush = NULL;
+    hanoi->checksum = 0;
+    return hanoi;
+}
+
+/* A traveling salesman over
+ * random points: the shortest
+ * round trip from city 0.
+ */
+struct tsp {
+    int num;
+    double *dist;
+    double *best_by_prefix;
+    double *held_karp;
+    int held_karp_size;
+    double best;
+};
+/* Beyond these the engines would
+ * not finish (or fit) so their
+ * rows are not executed.
+ */
+#define TSP_BRUTE_MAX 13
+#define HELD_KARP_MAX 20
+#define TSP_CHECK_MAX 9
+
+struct tsp* create_tsp(int num, struct rng *rng) {
+    struct tsp *tsp = arena_alloc(sizeof(struct tsp));
+    double *x = malloc(sizeof(double)*num), *y = malloc(sizeof(double)*num);
+    int i, j;
+
+    tsp->num = num;
+    tsp->dist = arena_alloc(sizeof(double)*num*num);
+    tsp->best_by_prefix = arena_alloc(sizeof(double)*num);
+    tsp->held_karp = num <= HELD_KARP_MAX ? arena_alloc(sizeof(double)*((size_t)1 << (num-1))*num) : NULL;
+    for(i = 0;i < num;i++) {
+        x[i] = rng_double(rng);
+        y[i] = rng_double(rng);
+    }
+    for(i = 0;i < num;i++) {
+        for(j = 0;j < num;j++) tsp->dist[i*num + j] = hypot(x[i] - x[j], y[i] - y[j]);
+    }
+    free(x);
+    free(y);
+    return tsp;
+}
+
+double tsp_tour_1(struct tsp *tsp, int *tour) {
+    double len = tsp->dist[tour[tsp->num - 1]*tsp->num];
+    int i;
+    for(i = 1;i < tsp->num;i++) len += tsp->dist[tour[i-1]*tsp->num + tour[i]];
+    return len;
+}
+/* [=] Every tour that starts at
+ * city 0 then goes to the city
+ * `task->low`: Heap's algorithm
+ * reaches each order of the rest
+ * with a single swap, in place.
+ */
+void tsp_brute_force_1(struct task *task) {
+    struct tsp *tsp = task->data;
+    int tour[TSP_BRUTE_MAX], c[TSP_BRUTE_MAX];
+    int *rest = tour + 2;
+    int m = tsp->num - 2;
+    int i, k;
+    long steps = 0;
+    double best;
+
+    tour[0] = 0;
+    tour[1] = task->low;
+    for(i = 1, k = 0;i < tsp->num;i++) if(i != task->low) rest[k++] = i;
+    for(i = 0;i < m;i++) c[i] = 0;
+
+    best = tsp_tour_1(tsp, tour);
+    i = 1;
+    while(i < m) {
+        if(c[i] < i) {
+            if(!(++steps & 0xFFFF) && CANCELLED()) break;
+            int j = i % 2 ? c[i] : 0, tmp = rest[j];
+            double len;
+            rest[j] = rest[i];
+            rest[i] = tmp;
+            len = tsp_tour_1(tsp, tour);
+            if(len < best) best = len;
+            c[i]++;
+            i = 1;
+        } else {
+            c[i++] = 0;
+        }
+    }
+    tsp->best_by_prefix[task->low] = best;
+}
+/* [=] Try every tour: O(n!). The
+ * tours are split by the second
+ * city so each thread takes a
+ * whole (n-2)! block of them.
+ */
+void tsp_brute_force(struct tsp *tsp) {
+    atomic_long pending;
+    struct task task;
+    int k;
+
+    tsp->best = tsp->num > 1 ? INFINITY : 0;
+    if(tsp->num < 3) {
+        if(tsp->num == 2) tsp->best = 2 * tsp->dist[1];
+        RESULT(tsp->best);
+        return;
+    }
+    atomic_init(&pending, 0);
+    task.run = &tsp_brute_force_1;
+    task.data = tsp;
+    task.pending = &pending;
+    for(k = 1;k < tsp->num;k++) {
+        task.low = k;
+        pool_submit(bench_pool, &task);
+    }
+    pool_wait(bench_pool, &pending);
+    for(k = 1;k < tsp->num;k++) {
+        if(tsp->best_by_prefix[k] < tsp->best) tsp->best = tsp->best_by_prefix[k];
+    }
+    RESULT(tsp->best);
+}
+
+/* Held-Karp: cost[set][j] is the
+ * shortest path from city 0
+ * through the cities in `set`
+ * (cities 1..n-1 as bits) that
+ * ends at `j`. Each set only
+ * depends on sets one smaller:
+ *  O(n^2 2^n)
+ */
+#define HELD_KARP_COST(tsp, set, j) ((tsp)->held_karp[(size_t)(set)*(tsp)->num + (j)])
+/* Sets handed to a thread at a
+ * time.
+ */
+#define HELD_KARP_GRAIN 1024
+void held_karp_1(struct task *task) {
+    struct tsp *tsp = task->data;
+    long set;
+    int j, k;
+
+    if(CANCELLED()) return;
+    for(set = task->low;set < task->high;set++) {
+        if(__builtin_popcountl(set) != tsp->held_karp_size) continue;
+        for(j = 1;j < tsp->num;j++) {
+            long prev = set & ~(1L << (j-1));
+            double best = INFINITY;
+            if(prev == set) continue;
+            for(k = 1;k < tsp->num;k++) {
+                double cost;
+                if(!(prev & (1L << (k-1)))) continue;
+                cost = HELD_KARP_COST(tsp, prev, k) + tsp->dist[k*tsp->num + j];
+                if(cost < best) best = cost;
+            }
+            HELD_KARP_COST(tsp, set, j) = best;
+        }
+    }
+}
+/* [=] Fill in the sets one size
+ * at a time - all the sets of a
+ * size are split across the pool
+ */
+void tsp_held_karp(struct tsp *tsp) {
+    long num_sets, set;
+    int size, j;
+
+    tsp->best = 0;
+    if(tsp->num < 2) {
+        RESULT(tsp->best);
+        return;
+    }
+    num_sets = 1L << (tsp->num - 1);
+    for(j = 1;j < tsp->num;j++) HELD_KARP_COST(tsp, 1L << (j-1), j) = tsp->dist[j];
+
+    for(size = 2;size < tsp->num;size++) {
+        atomic_long pending;
+        struct task task;
+
+        tsp->held_karp_size = size;
+        atomic_init(&pending, 0);
+        task.run = &held_karp_1;
+        task.data = tsp;
+        task.pending = &pending;
+        for(set = 0;set < num_sets;set += HELD_KARP_GRAIN) {
+            task.low = set;
+            task.high = set + HELD_KARP_GRAIN < num_sets ? set + HELD_KARP_GRAIN : num_sets;
+            pool_submit(bench_pool, &task);
+        }
+        pool_wait(bench_pool, &pending);
+    }
+
+    tsp->best = INFINITY;
+    for(j = 1;j < tsp->num;j++) {
+        double cost = HELD_KARP_COST(tsp, num_sets - 1, j) + tsp->dist[j*tsp->num];
+        if(cost < tsp->best) tsp->best = cost;
+    }
+    RESULT(tsp->best);
+}
+int check_tsp(struct tsp *tsp) {
+    double brute, held_karp;
+
+    tsp_brute_force(tsp);
+    brute = tsp->best;
+    tsp_held_karp(tsp);
+    held_karp = tsp->best;
+    if(fabs(brute - held_karp) < 1e-9) return 1;
+
+    fprintf(stderr, "tsp engines disagree: brute force %f held-karp %f\n", brute, held_karp);
+    return 0;
+}
+
+/* Searches written once for
+ * any element type and made
+ * for each one below, so the
+ * same search can be compared
+ * on narrow, wide and floating
+ * point elements.
+ */
+#define TYPED_SEARCH(T, suffix) \
+    struct search_##suffix { \
+        T needle; \
+        long sz; \
+        T *vals; \
+    }; \
+    void linear_search_##suffix(struct search_##suffix *s) { \
+        long i; \
+        for(i = 0;i < s->sz;i++) { \
+            if(s->vals[i] == s->needle) { \
+                RESULT(FOUND); \
+                return; \
+            } \
+        } \
+        RESULT(NOT_FOUND); \
+    } \
+    void branchless_search_##suffix(struct search_##suffix *s) { \
+        T *base = s->vals; \
+        long n = s->sz; \
+        while(n > 1) { \
+            long half = n / 2; \
+            __builtin_prefetch(base + half/2); \
+            __builtin_prefetch(base + half + half/2); \
+            base = (base[half] <= s->needle) ? base + half : base; \
+            n -= half; \
+        } \
+        if(s->sz > 0 && *base == s->needle) RESULT(FOUND); \
+        else RESULT(NOT_FOUND); \
+    } \
+    /* [=] From a sorted haystack - \
+     * the conversion keeps it \
+     * sorted */ \
+    struct search_##suffix* create_search_##suffix(struct search *s) { \
+        struct search_##suffix *ts = arena_alloc(sizeof(struct search_##suffix)); \
+        long i; \
+        ts->needle = (T)s->needle; \
+        ts->sz = s->haystack->sz; \
+        ts->vals = arena_alloc(ts->sz*sizeof(T)); \
+        for(i = 0;i < ts->sz;i++) ts->vals[i] = (T)s->haystack->vals[i]; \
+        return ts; \
+    }
+TYPED_SEARCH(int32_t, i32)
+TYPED_SEARCH(int64_t, i64)
+TYPED_SEARCH(float, f32)
+
+/* A sorted haystack packed like
+ * a posting list: blocks of
+ * PACK_BLOCK items, each item
+ * stored as its gap from the one
+ * PACK_LANES before it in the
+ * fewest bits that hold the
+ * block's largest gap. Item j of
+ * a block lives in lane j % 8,
+ * so 8 lanes unpack (and add up
+ * their gaps) side by side. The
+ * skip index has the first item
+ * of each block and where its
+ * bits start.
+ */
+#define PACK_BLOCK 128
+#define PACK_LANES 8
+#define PACK_ROWS (PACK_BLOCK / PACK_LANES)
+struct packed_array {
+    long sz;
+    long num_blocks;
+    int *firsts;
+    long *starts;
+    unsigned char *bits;
+    uint32_t *words;
+    /* all of it, skip index too */
+    long bytes;
+};
+struct packed_search {
+    int needle;
+    struct packed_array *haystack;
+};
+long pack_count_1(struct packed_array *pa, long block) {
+    long left = pa->sz - block*PACK_BLOCK;
+    return left < PACK_BLOCK ? left : PACK_BLOCK;
+}
+/* [=] The gap of item j of the
+ * block at `from` - a short last
+ * block repeats its last item.
+ * Sorted so it never goes
+ * negative (and always fits 32
+ * bits). */
+uint32_t pack_gap_1(struct array *array, long from, int j) {
+    long at = from + j < array->sz ? from + j : array->sz - 1;
+    long before = j < PACK_LANES ? from : (from + j - PACK_LANES < array->sz ? from + j - PACK_LANES : array->sz - 1);
+    return (uint32_t)array->vals[at] - (uint32_t)array->vals[before];
+}
+struct packed_array* pack_array(struct array *array) {
+    struct packed_array *pa = arena_alloc(sizeof(struct packed_array));
+    long block, num_words = 0;
+    int j;
+
+    pa->sz = array->sz;
+    pa->num_blocks = (array->sz + PACK_BLOCK - 1) / PACK_BLOCK;
+    pa->firsts = arena_alloc(sizeof(int)*pa->num_blocks);
+    pa->starts = arena_alloc(sizeof(long)*pa->num_blocks);
+    pa->bits = arena_alloc(pa->num_blocks);
+    for(block = 0;block < pa->num_blocks;block++) {
+        uint32_t most = 0;
+        for(j = 0;j < PACK_BLOCK;j++) most |= pack_gap_1(array, block*PACK_BLOCK, j);
+        pa->firsts[block] = array->vals[block*PACK_BLOCK];
+        pa->bits[block] = most ? 32 - __builtin_clz(most) : 0;
+        pa->starts[block] = num_words;
+        num_words += PACK_LANES * ((PACK_ROWS*pa->bits[block] + 31) / 32);
+    }
+    /* a spare row so unpacking
+     * can always read one word
+     * ahead */
+    pa->words = arena_alloc(sizeof(uint32_t)*(num_words + PACK_LANES));
+    for(block = 0;block < pa->num_blocks;block++) {
+        uint32_t *w = pa->words + pa->starts[block];
+        int bits = pa->bits[block];
+        for(j = 0;j < PACK_BLOCK && bits;j++) {
+            uint32_t gap = pack_gap_1(array, block*PACK_BLOCK, j);
+            long p = (long)(j / PACK_LANES) * bits, k = p / 32;
+            int s = p % 32, lane = j % PACK_LANES;
+            w[k*PACK_LANES + lane] |= gap << s;
+            if(s + bits > 32) w[(k+1)*PACK_LANES + lane] |= gap >> (32 - s);
+        }
+    }
+    pa->bytes = sizeof(struct packed_array) + pa->num_blocks*(sizeof(int) + sizeof(long) + 1)
+        + sizeof(uint32_t)*(num_words + PACK_LANES);
+    return pa;
+}
+struct packed_search* create_packed_search(struct search *s) {
+    struct packed_search *ps = arena_alloc(sizeof(struct packed_search));
+    ps->needle = s->needle;
+    ps->haystack = pack_array(s->haystack);
+    return ps;
+}
+
+/* [=] Unpack a whole block: each
+ * row is one shift (and a second
+ * for bits that spill into the
+ * next word) then a running add
+ * per lane */
+void unpack_block_scalar(struct packed_array *pa, long block, int *out) {
+    uint32_t *w = pa->words + pa->starts[block];
+    int bits = pa->bits[block];
+    uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+    uint32_t acc[PACK_LANES];
+    int r, lane;
+
+    for(lane = 0;lane < PACK_LANES;lane++) acc[lane] = pa->firsts[block];
+    for(r = 0;r < PACK_ROWS;r++) {
+        long p = (long)r * bits, k = p / 32;
+        int s = p % 32;
+        for(lane = 0;lane < PACK_LANES;lane++) {
+            uint32_t gap = w[k*PACK_LANES + lane] >> s;
+            if(s + bits > 32) gap |= w[(k+1)*PACK_LANES + lane] << (32 - s);
+            acc[lane] += gap & mask;
+            out[r*PACK_LANES + lane] = acc[lane];
+        }
+    }
+}
+#if defined(__x86_64__) || defined(__i386__)
+/* [=] A row is one vector: the
+ * shift left by 32 for a row
+ * that doesn't spill is zero so
+ * there is no branch */
+__attribute__((target("avx2")))
+void unpack_block_avx2(struct packed_array *pa, long block, int *out) {
+    uint32_t *w = pa->words + pa->starts[block];
+    int bits = pa->bits[block];
+    __m256i mask = _mm256_set1_epi32(bits == 32 ? -1 : (int)((1u << bits) - 1));
+    __m256i acc = _mm256_set1_epi32(pa->firsts[block]);
+    int r;
+
+    for(r = 0;r < PACK_ROWS;r++) {
+        long p = (long)r * bits, k = p / 32;
+        int s = p % 32;
+        __m256i lo = _mm256_srl_epi32(_mm256_loadu_si256((__m256i*)(w + k*PACK_LANES)), _mm_cvtsi32_si128(s));
+        __m256i hi = _mm256_sll_epi32(_mm256_loadu_si256((__m256i*)(w + (k+1)*PACK_LANES)), _mm_cvtsi32_si128(32 - s));
+        acc = _mm256_add_epi32(acc, _mm256_and_si256(_mm256_or_si256(lo, hi), mask));
+        _mm256_storeu_si256((__m256i*)(out + r*PACK_LANES), acc);
+    }
+}
+#endif
+static void (*unpack_block)(struct packed_array *pa, long block, int *out) = &unpack_block_scalar;
+void select_unpack(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) unpack_block = &unpack_block_avx2;
+#endif
+}
+
+/* [=] binary_jump_search over the
+ * skip index, then unpack just
+ * the one block the needle can
+ * be in */
+void packed_binary_search(struct packed_search *s) {
+    struct packed_array *pa = s->haystack;
+    long jump = pa->num_blocks / 2;
+    long pos = 0;
+    int vals[PACK_BLOCK];
+
+    if(!pa->num_blocks) {
+        RESULT(NOT_FOUND);
+        return;
+    }
+    while(jump > 0) {
+        while(pos + jump < pa->num_blocks && pa->firsts[pos+jump] <= s->needle) pos+=jump;
+        jump = jump / 2;
+    }
+    unpack_block(pa, pos, vals);
+    if(find_first_engine.find(vals, pack_count_1(pa, pos), s->needle) >= 0) RESULT(FOUND);
+    else RESULT(NOT_FOUND);
+}
+/* [=] linear_search a block at a
+ * time - less memory to read the
+ * denser the items (about 40% of
+ * the plain array at 1e7, 90% at
+ * 1e3) */
+void packed_linear_search(struct packed_search *s) {
+    struct packed_array *pa = s->haystack;
+    int vals[PACK_BLOCK];
+    long block;
+
+    for(block = 0;block < pa->num_blocks;block++) {
+        unpack_block(pa, block, vals);
+        if(find_first_engine.find(vals, pack_count_1(pa, block), s->needle) >= 0) {
+            RESULT(FOUND);
+            return;
+        }
+    }
+    RESULT(NOT_FOUND);
+}
+
+#ifdef BIGO_OFFLOAD
+/* Offloaded engines (built with
+ * -fopenmp -DBIGO_OFFLOAD). They
+ * run as OpenMP target regions -
+ * on a GPU if the compiler has
+ * an offload target for one,
+ * else on the host. Each keeps
+ * its own device copies, made
+ * at setup and timed apart from
+ * its kernels so the rows show
+ * what the copies cost.
+ */
+#define OFFLOAD_BUFFERS 4
+#define OFFLOAD_GRAIN (1L << 16)
+struct offload {
+    void *device[OFFLOAD_BUFFERS];
+    int num;
+    long long to_device_ns;
+    long long from_device_ns;
+};
+/* [=] Device memory that goes
+ * when the offload is released */
+void* offload_alloc_1(struct offload *o, size_t bytes) {
+    void *device = omp_target_alloc(bytes ? bytes : 1, omp_get_default_device());
+    if(device) o->device[o->num++] = device;
+    return device;
+}
+void* offload_copy_in_1(struct offload *o, void *host, size_t bytes) {
+    void *device = offload_alloc_1(o, bytes);
+    long long begin = now_ns();
+
+    if(device) omp_target_memcpy(device, host, bytes, 0, 0, omp_get_default_device(), omp_get_initial_device());
+    o->to_device_ns += now_ns() - begin;
+    return device;
+}
+void offload_copy_out_1(struct offload *o, void *host, void *device, size_t bytes) {
+    long long begin = now_ns();
+    omp_target_memcpy(host, device, bytes, 0, 0, omp_get_initial_device(), omp_get_default_device());
+    o->from_device_ns += now_ns() - begin;
+}
+/* [=] The release hook - every
+ * offload struct starts with a
+ * struct offload */
+void offload_release(void *data) {
+    struct offload *o = data;
+    while(o->num > 0) omp_target_free(o->device[--o->num], omp_get_default_device());
+}
+
+struct offload_search {
+    struct offload o;
+    int needle;
+    long sz;
+    int *vals;
+};
+struct offload_search* create_offload_search(struct search *s) {
+    struct offload_search *os = arena_alloc(sizeof(struct offload_search));
+    int found;
+
+    os->needle = s->needle;
+    os->sz = s->haystack->sz;
+    os->vals = offload_copy_in_1(&os->o, s->haystack->vals, sizeof(int)*os->sz);
+    if(!os->vals) return NULL;
+    /* all that comes back */
+    offload_copy_out_1(&os->o, &found, os->vals, sizeof(int));
+    return os;
+}
+/* [=] Every item at once - the
+ * first match is a min
+ * reduction */
+void offload_linear_search(struct offload_search *s) {
+    int *vals = s->vals, needle = s->needle;
+    long n = s->sz, first = n, i;
+
+    #pragma omp target teams distribute parallel for reduction(min:first) map(tofrom:first) is_device_ptr(vals)
+    for(i = 0;i < n;i++) {
+        if(vals[i] == needle && i < first) first = i;
+    }
+    if(first < n) RESULT(FOUND);
+    else RESULT(NOT_FOUND);
+}
+
+struct offload_slices {
+    struct offload o;
+    long sz;
+    int *vals;
+    long root_sz;
+    long num_slices;
+    long *slice_sum;
+};
+struct offload_slices* create_offload_slices(struct array *array, long slice_sz) {
+    struct offload_slices *os = arena_alloc(sizeof(struct offload_slices));
+    long *host;
+
+    os->sz = array->sz;
+    os->root_sz = slice_sz > 0 ? slice_sz : (long)sqrt(array->sz);
+    if(os->root_sz < 1) os->root_sz = 1;
+    os->num_slices = array->sz/os->root_sz + 1;
+    os->vals = offload_copy_in_1(&os->o, array->vals, sizeof(int)*os->sz);
+    os->slice_sum = offload_alloc_1(&os->o, sizeof(long)*os->num_slices);
+    if(!os->vals || !os->slice_sum) return NULL;
+    host = malloc(sizeof(long)*os->num_slices);
+    offload_copy_out_1(&os->o, host, os->slice_sum, sizeof(long)*os->num_slices);
+    free(host);
+    return os;
+}
+/* [=] A slice per thread, the
+ * sums stay on the device */
+void offload_slice_sums(struct offload_slices *os) {
+    int *vals = os->vals;
+    long *slice_sum = os->slice_sum;
+    long n = os->sz, root_sz = os->root_sz, num_slices = os->num_slices, slice;
+    long long total = 0;
+
+    #pragma omp target teams distribute parallel for reduction(+:total) map(tofrom:total) is_device_ptr(vals, slice_sum)
+    for(slice = 0;slice < num_slices;slice++) {
+        long from = slice*root_sz, to = from + root_sz < n ? from + root_sz : n, i;
+        long sum = 0;
+        for(i = from;i < to;i++) sum += vals[i];
+        slice_sum[slice] = sum;
+        total += sum;
+    }
+    RESULT(total);
+}
+
+/* Max sequential sum in blocks:
+ * each block boils down to its
+ * sum, best prefix, best suffix
+ * and best inside, and those
+ * chain together in order.
+ */
+struct offload_max_seq {
+    struct offload o;
+    long sz;
+    int *vals;
+    long num_blocks;
+    long long *blocks;
+};
+struct offload_max_seq* create_offload_max_seq(struct array *array) {
+    struct offload_max_seq *ms = arena_alloc(sizeof(struct offload_max_seq));
+    long long best;
+
+    ms->sz = array->sz;
+    ms->num_blocks = (array->sz + OFFLOAD_GRAIN - 1) / OFFLOAD_GRAIN;
+    ms->vals = offload_copy_in_1(&ms->o, array->vals, sizeof(int)*ms->sz);
+    ms->blocks = offload_alloc_1(&ms->o, 4*sizeof(long long)*ms->num_blocks);
+    if(!ms->vals || !ms->blocks) return NULL;
+    offload_copy_out_1(&ms->o, &best, ms->blocks, sizeof(long long));
+    return ms;
+}
+void offload_max_seq_sum(struct offload_max_seq *ms) {
+    int *vals = ms->vals;
+    long long *blocks = ms->blocks;
+    long n = ms->sz, num_blocks = ms->num_blocks, b;
+    long long best = 0;
+
+    #pragma omp target teams distribute parallel for is_device_ptr(vals, blocks)
+    for(b = 0;b < num_blocks;b++) {
+        long from = b*OFFLOAD_GRAIN, to = from + OFFLOAD_GRAIN < n ? from + OFFLOAD_GRAIN : n, i;
+        long long sum = 0, prefix = 0, curr = 0, inside = 0;
+        for(i = from;i < to;i++) {
+            sum += vals[i];
+            if(sum > prefix) prefix = sum;
+            /* Kadane - which ends on
+             * the best suffix */
+            curr += vals[i];
+            if(curr < 0) curr = 0;
+            if(curr > inside) inside = curr;
+        }
+        blocks[4*b] = sum;
+        blocks[4*b+1] = prefix;
+        blocks[4*b+2] = curr;
+        blocks[4*b+3] = inside;
+    }
+    #pragma omp target map(tofrom:best) is_device_ptr(blocks)
+    {
+        long long suffix = 0;
+        long k;
+        for(k = 0;k < num_blocks;k++) {
+            if(suffix + blocks[4*k+1] > best) best = suffix + blocks[4*k+1];
+            if(blocks[4*k+3] > best) best = blocks[4*k+3];
+            suffix = suffix + blocks[4*k] > blocks[4*k+2] ? suffix + blocks[4*k] : blocks[4*k+2];
+        }
+    }
+    RESULT(best);
+}
+
+/* LSD radix sort, 8 bits a pass:
+ * each block counts its digits,
+ * every digit's column of
+ * counts becomes offsets, and
+ * each block scatters its items
+ * in order (so it is stable).
+ */
+struct offload_sort {
+    struct offload o;
+    long sz;
+    int *pristine;
+    int *work;
+    int *scratch;
+    long num_blocks;
+    long *counts;
+};
+struct offload_sort* create_offload_sort(struct array *array) {
+    struct offload_sort *os = arena_alloc(sizeof(struct offload_sort));
+    int *host;
+
+    os->sz = array->sz;
+    os->num_blocks = (array->sz + OFFLOAD_GRAIN - 1) / OFFLOAD_GRAIN;
+    os->pristine = offload_copy_in_1(&os->o, array->vals, sizeof(int)*os->sz);
+    os->work = offload_alloc_1(&os->o, sizeof(int)*os->sz);
+    os->scratch = offload_alloc_1(&os->o, sizeof(int)*os->sz);
+    os->counts = offload_alloc_1(&os->o, sizeof(long)*(os->num_blocks + 1)*RADIX_BUCKETS);
+    if(!os->pristine || !os->work || !os->scratch || !os->counts) return NULL;
+    host = malloc(sizeof(int)*os->sz);
+    offload_copy_out_1(&os->o, host, os->work, sizeof(int)*os->sz);
+    free(host);
+    return os;
+}
+/* [=] Setup hook: sort a fresh
+ * copy (on the device) each run */
+void offload_sort_reset(void *data) {
+    struct offload_sort *os = data;
+    int *pristine = os->pristine, *work = os->work;
+    long n = os->sz, i;
+
+    #pragma omp target teams distribute parallel for is_device_ptr(pristine, work)
+    for(i = 0;i < n;i++) work[i] = pristine[i];
+}
+void offload_radix_sort(struct offload_sort *os) {
+    int *from = os->work, *to = os->scratch, *tmp;
+    long *counts = os->counts;
+    long n = os->sz, num_blocks = os->num_blocks, b;
+    int pass, d;
+
+    for(pass = 0;pass < RADIX_PASSES;pass++) {
+        int shift = pass * RADIX_BITS;
+        /* the last row holds where
+         * each digit starts */
+        long *starts = counts + num_blocks*RADIX_BUCKETS;
+
+        #pragma omp target teams distribute parallel for is_device_ptr(from, counts)
+        for(b = 0;b < num_blocks;b++) {
+            long *count = counts + b*RADIX_BUCKETS, i;
+            long end = (b + 1)*OFFLOAD_GRAIN < n ? (b + 1)*OFFLOAD_GRAIN : n;
+            int k;
+            for(k = 0;k < RADIX_BUCKETS;k++) count[k] = 0;
+            for(i = b*OFFLOAD_GRAIN;i < end;i++) count[(((unsigned)from[i] ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        #pragma omp target teams distribute parallel for is_device_ptr(counts, starts)
+        for(d = 0;d < RADIX_BUCKETS;d++) {
+            long run = 0, k;
+            for(k = 0;k < num_blocks;k++) {
+                long c = counts[k*RADIX_BUCKETS + d];
+                counts[k*RADIX_BUCKETS + d] = run;
+                run += c;
+            }
+            starts[d] = run;
+        }
+        #pragma omp target is_device_ptr(starts)
+        {
+            long run = 0;
+            int k;
+            for(k = 0;k < RADIX_BUCKETS;k++) {
+                long c = starts[k];
+                starts[k] = run;
+                run += c;
+            }
+        }
+        #pragma omp target teams distribute parallel for is_device_ptr(from, to, counts, starts)
+        for(b = 0;b < num_blocks;b++) {
+            long *count = counts + b*RADIX_BUCKETS, i;
+            long end = (b + 1)*OFFLOAD_GRAIN < n ? (b + 1)*OFFLOAD_GRAIN : n;
+            for(i = b*OFFLOAD_GRAIN;i < end;i++) {
+                unsigned digit = (((unsigned)from[i] ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1);
+                to[starts[digit] + count[digit]++] = from[i];
+            }
+        }
+        tmp = from;
+        from = to;
+        to = tmp;
+    }
+}
+#endif
+
+/* The sort engines to choose
+ * from when sorting the
+ * haystacks.
+ */
+struct sort_engine {
+    char *name;
+    void (*sort)(struct array *array);
+};
+struct sort_engine sort_engines[] = {
+    { "quick", &quick_sort },
+    { "intro", &intro_sort },
+    { "parallel", &parallel_quick_sort },
+    { "radix", &radix_sort_array },
+    { NULL, NULL },
+};
+
+
+/* (actually run algos and show results) */
+
+char* oclass_1_str(enum OClass oclass) {
+    switch(oclass) {
+        case O1: return "O(1)";
+        case O_logn: return "O(log(n))";
+        case O_sqrtn: return "O(sqrt(n))";
+        case O_n: return "O(n)";
+        case O_nlogn: return "O(n log(n))";
+        case O_n_power_2: return "O(n^2)";
+        case O_2_power_n: return "O(2^n)";
+        case O_n_permut: return "O(n!)";
+        case O_n_power_n: return "O(n^n)";
+        default: return "ERROR!";
+    }
+}
+/* The shapes of input data. */
+enum distribution {
+    UNIFORM,
+    SORTED,
+    REVERSED,
+    FEW_UNIQUE_VALUES,
+    ZIPF,
+};
+char* distribution_1_str(enum distribution distribution) {
+    switch(distribution) {
+        case UNIFORM: return "uniform";
+        case SORTED: return "sorted";
+        case REVERSED: return "reversed";
+        case FEW_UNIQUE_VALUES: return "few-unique";
+        case ZIPF: return "zipf";
+        default: return "ERROR!";
+    }
+}
+
+/* How results are written. */
+enum format {
+    TEXT_FORMAT,
+    JSON_FORMAT,
+    CSV_FORMAT,
+};
+
+/* The benchmark settings. */
+struct options {
+    long sz;
+    char *sweep;
+    int samples;
+    struct sort_engine *sort;
+    int threads;
+    long batch;
+    long range_ops;
+    int updates;
+    long slice;
+    double budget;
+    uint64_t seed;
+    enum distribution distribution;
+    char *cache;
+    char *only;
+    enum format format;
+    char *compare[2];
+    double threshold;
+    int counters;
+    int verify;
+    /* out of core items and the
+     * items read at a time */
+    long stream;
+    long chunk;
+    /* show each row per element
+     * or probe */
+    int per_unit;
+    /* environments run at once */
+    int jobs;
+    int isolated;
+};
+static struct options options = {
+    .samples = 15,
+    .threads = 1,
+    .batch = 1000,
+    .range_ops = 1000,
+    .updates = 10,
+    .budget = 10,
+    .seed = 1,
+    .threshold = 5,
+};
+
+/* (hardware counters) */
+
+/* With --counters each row also
+ * shows what the cpu was doing:
+ * the numbers the eytzinger,
+ * branchless and simd engines
+ * are meant to move. Counters
+ * the kernel won't give us are
+ * shown as "-".
+ *
+ * NB: they count the thread
+ * that runs the algorithm, so
+ * for the parallel engines only
+ * the share the main thread
+ * does.
+ */
+enum counter {
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    DTLB_MISSES,
+    NUM_COUNTERS,
+};
+static char *counter_names[NUM_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses",
+};
+static int counter_fds[NUM_COUNTERS] = { -1, -1, -1, -1, -1, -1 };
+/* [=] Only count the timed
+ * samples - not calibration or
+ * warmups
+ */
+static _Thread_local int counting;
+
+#ifdef __linux__
+int counter_open_1(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#define HW_CACHE_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+#endif
+
+/* [=] Open what we can. Returns
+ * how many counters we got.
+ */
+int counters_open() {
+    int i, num = 0;
+
+#ifdef __linux__
+    counter_fds[CYCLES] = counter_open_1(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counter_fds[INSTRUCTIONS] = counter_open_1(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counter_fds[L1D_MISSES] = counter_open_1(PERF_TYPE_HW_CACHE, HW_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D));
+    counter_fds[LLC_MISSES] = counter_open_1(PERF_TYPE_HW_CACHE, HW_CACHE_MISS(PERF_COUNT_HW_CACHE_LL));
+    counter_fds[BRANCH_MISSES] = counter_open_1(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    counter_fds[DTLB_MISSES] = counter_open_1(PERF_TYPE_HW_CACHE, HW_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB));
+#endif
+    for(i = 0;i < NUM_COUNTERS;i++) if(counter_fds[i] >= 0) num++;
+    if(!num) fprintf(stderr, "hardware counters unavailable: %s\n", strerror(errno));
+    return num;
+}
+
+void counters_1(unsigned long request) {
+#ifdef __linux__
+    int i;
+    for(i = 0;i < NUM_COUNTERS;i++) {
+        if(counter_fds[i] >= 0) ioctl(counter_fds[i], request, 0);
+    }
+#endif
+}
+void counters_reset() {
+#ifdef __linux__
+    counters_1(PERF_EVENT_IOC_RESET);
+#endif
+}
+void counters_resume() {
+#ifdef __linux__
+    if(counting) counters_1(PERF_EVENT_IOC_ENABLE);
+#endif
+}
+void counters_pause() {
+#ifdef __linux__
+    if(counting) counters_1(PERF_EVENT_IOC_DISABLE);
+#endif
+}
+/* [=] Read the counts per call
+ * (scaled up if the kernel had
+ * to share the counters). -1
+ * for those we don't have.
+ */
+void counters_read(double *vals, long calls) {
+    int i;
+
+    for(i = 0;i < NUM_COUNTERS;i++) {
+        uint64_t v[3];
+        vals[i] = -1;
+        if(counter_fds[i] < 0 || calls < 1) continue;
+        if(read(counter_fds[i], v, sizeof(v)) != sizeof(v) || !v[2]) continue;
+        vals[i] = (double)v[0] * ((double)v[1] / v[2]) / calls;
+    }
+}
+
+/* [=] A "VmXXX:" field of
+ * /proc/self/status in bytes -
+ * 0 if we can't tell
+ */
+long status_bytes_1(char *field) {
+    char line[256];
+    size_t len = strlen(field);
+    long kb = 0;
+    FILE *f = fopen("/proc/self/status", "r");
+
+    if(!f) return 0;
+    while(fgets(line, sizeof(line), f)) {
+        if(!strncmp(line, field, len) && line[len] == ':') {
+            kb = atol(line + len + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return kb * 1024;
+}
+/* [=] Start measuring the peak
+ * resident memory afresh -
+ * write 5 to clear_refs resets
+ * VmHWM to what's resident now
+ */
+void reset_peak_rss() {
+    int fd = open("/proc/self/clear_refs", O_WRONLY);
+    if(fd < 0) return;
+    if(write(fd, "5", 1) != 1) {
+        /* old kernel - the peak is
+         * then since process start */
+    }
+    close(fd);
+}
+long peak_rss() {
+    return status_bytes_1("VmHWM");
+}
+
+/* Each sample must run at
+ * least this long for the clock
+ * to measure it well.
+ */
+#define BENCH_MIN_SAMPLE_NS 1000000LL
+#define BENCH_MAX_ITERS (1L<<30)
+#define BENCH_WARMUP_SAMPLES 2
+
+/* The statistics of the
+ * samples, all in nanoseconds
+ * per call of the algorithm.
+ */
+struct stats {
+    int samples;
+    int over_budget;
+    long iters;
+    double min;
+    double median;
+    double mean;
+    double p99;
+    double stddev;
+    /* resident memory before and
+     * at its peak while running */
+    long rss;
+    long peak_rss;
+    /* per call - see counters_read */
+    double counters[NUM_COUNTERS];
+};
+
+/* [=] Time `iters` back to back
+ * calls of the algorithm. If
+ * the environment has hooks
+ * each call is timed alone so
+ * the hooks stay outside the
+ * timing.
+ */
+long long time_iters_1(struct environment* environment, long iters) {
+    long long begin, end, total = 0;
+    long k;
+
+    if(!environment->setup && !environment->teardown) {
+        counters_resume();
+        begin = now_ns();
+        environment->algo(environment->data, iters);
+        end = now_ns();
+        counters_pause();
+        return end - begin;
+    }
+
+    for(k = 0;k < iters;k++) {
+        if(environment->setup) environment->setup(environment->fixture);
+        counters_resume();
+        begin = now_ns();
+        environment->algo(environment->data, 1);
+        end = now_ns();
+        counters_pause();
+        if(environment->teardown) environment->teardown(environment->fixture);
+        total += end - begin;
+    }
+    return total;
+}
+
+/* [=] Double the iterations
+ * until a sample is long enough
+ * to measure
+ */
+long calibrate_iters(struct environment* environment, long long *sample_ns) {
+    long iters = 1;
+    while((*sample_ns = time_iters_1(environment, iters)) < BENCH_MIN_SAMPLE_NS &&
+            iters < BENCH_MAX_ITERS && !CANCELLED()) {
+        iters *= 2;
+    }
+    return iters;
+}
+
+/* The watchdog sets the cancel
+ * flag of an environment when
+ * its budget runs out.
+ */
+struct watchdog {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct timespec deadline;
+    int done;
+    atomic_int cancel;
+};
+void* watchdog_1(void *arg) {
+    struct watchdog *w = arg;
+
+    pthread_mutex_lock(&w->lock);
+    while(!w->done) {
+        if(pthread_cond_timedwait(&w->cond, &w->lock, &w->deadline) == ETIMEDOUT) {
+            atomic_store(&w->cancel, 1);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+void watchdog_start(struct watchdog *w, double seconds) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&w->lock, NULL);
+    atomic_init(&w->cancel, 0);
+    w->done = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &w->deadline);
+    w->deadline.tv_sec += (time_t)seconds;
+    w->deadline.tv_nsec += (long)((seconds - (time_t)seconds) * 1e9);
+    if(w->deadline.tv_nsec >= 1000000000L) {
+        w->deadline.tv_sec++;
+        w->deadline.tv_nsec -= 1000000000L;
+    }
+
+    bench_cancel = &w->cancel;
+    pthread_create(&w->thread, NULL, watchdog_1, w);
+}
+void watchdog_stop(struct watchdog *w) {
+    pthread_mutex_lock(&w->lock);
+    w->done = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    pthread_join(w->thread, NULL);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    bench_cancel = NULL;
+}
+
+int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* [=] Calibrate, warm up, and
+ * then collect the samples for
+ * an environment.
+ */
+struct stats bench_environment(struct environment* environment) {
+    struct stats stats;
+    struct watchdog watchdog;
+    long long begin = now_ns(), sample_ns;
+    double *ts = malloc(sizeof(double)*options.samples);
+    double var = 0;
+    int warmups = BENCH_WARMUP_SAMPLES;
+    int i, samples = options.samples;
+
+    if(options.budget > 0) watchdog_start(&watchdog, options.budget);
+
+    stats.samples = 0;
+    stats.over_budget = 0;
+    /* memory is per process so
+     * means nothing with others
+     * running alongside */
+    stats.rss = stats.peak_rss = 0;
+    if(!bench_runner) {
+        reset_peak_rss();
+        stats.rss = status_bytes_1("VmRSS");
+    }
+    stats.iters = calibrate_iters(environment, &sample_ns);
+
+    /* with a budget, take only the
+     * samples that fit in it */
+    if(options.budget > 0 && sample_ns > 0) {
+        double left = options.budget * 1e9 - (now_ns() - begin);
+        long fit = (long)(left / sample_ns);
+        if(fit < samples) samples = fit > 1 ? fit : 1;
+        if(fit - samples < warmups) warmups = fit - samples > 0 ? fit - samples : 0;
+    }
+
+    for(i = 0;i < warmups && !CANCELLED();i++) {
+        time_iters_1(environment, stats.iters);
+    }
+    counters_reset();
+    counting = options.counters;
+    for(i = 0;i < samples && !CANCELLED();i++) {
+        double t = (double)time_iters_1(environment, stats.iters) / stats.iters;
+        /* a cancelled run was cut
+         * short - drop it */
+        if(!CANCELLED()) ts[stats.samples++] = t;
+    }
+    counting = 0;
+    counters_read(stats.counters, (long)i * stats.iters);
+
+    if(options.budget > 0) watchdog_stop(&watchdog);
+    if(!bench_runner) stats.peak_rss = peak_rss();
+
+    if(stats.samples == 0) {
+        stats.over_budget = 1;
+        free(ts);
+        return stats;
+    }
+
+    qsort(ts, stats.samples, sizeof(double), cmp_double);
+    stats.min = ts[0];
+    stats.median = stats.samples % 2 ? ts[stats.samples/2]
+        : (ts[stats.samples/2 - 1] + ts[stats.samples/2]) / 2;
+    stats.p99 = ts[(int)ceil(0.99 * stats.samples) - 1];
+    stats.mean = 0;
+    for(i = 0;i < stats.samples;i++) stats.mean += ts[i];
+    stats.mean /= stats.samples;
+    for(i = 0;i < stats.samples;i++) var += (ts[i] - stats.mean) * (ts[i] - stats.mean);
+    stats.stddev = stats.samples > 1 ? sqrt(var / (stats.samples - 1)) : 0;
+
+    free(ts);
+    return stats;
+}
+
+/* [=] What a row's time is per:
+ * a probe for searches and
+ * queries, an element for the
+ * rest. Returns how many of
+ * them one run does.
+ */
+double per_unit_1(struct environment *environment, char **unit) {
+    if(environment->queries) {
+        *unit = "probe";
+        return environment->queries;
+    }
+    if(environment->oclass == O1 || environment->oclass == O_logn || environment->oclass == O_sqrtn) {
+        *unit = "probe";
+        return 1;
+    }
+    *unit = "elem";
+    return environment->n;
+}
+/* [=] A row that probes the same
+ * needle on every call - its
+ * path stays in L1 however big
+ * the input is
+ */
+int same_probe_1(struct environment *environment) {
+    char *unit;
+    per_unit_1(environment, &unit);
+    return !environment->queries && !strcmp(unit, "probe");
+}
+/* [=] The bytes a row works on -
+ * its own if it says, else the
+ * plain int array
+ */
+long row_bytes_1(struct environment *environment) {
+    return environment->bytes ? (long)environment->bytes : environment->n * (long)sizeof(int);
+}
+
+/* (machine readable results) */
+
+/* With --format json|csv each
+ * row is a record carrying what
+ * a dashboard needs to tell runs
+ * apart: the machine, compiler
+ * and commit.
+ */
+
+/* The build can pass its exact
+ * flags and commit - otherwise
+ * we say what the compiler lets
+ * us see.
+ */
+#ifndef BIGO_CFLAGS
+#define BIGO_CFLAGS ""
+#endif
+#ifndef BIGO_GIT_HASH
+#define BIGO_GIT_HASH ""
+#endif
+
+struct run_meta {
+    char cpu[256];
+    char compiler[256];
+    char flags[512];
+    char git[64];
+};
+static struct run_meta run_meta;
+
+void chomp_1(char *s) {
+    size_t len = strlen(s);
+    while(len && (s[len-1] == '\n' || s[len-1] == ' ')) s[--len] = 0;
+}
+void cpu_model_1(char *cpu, size_t len) {
+    char line[512];
+    FILE *f = fopen("/proc/cpuinfo", "r");
+
+    snprintf(cpu, len, "unknown");
+    if(!f) return;
+    while(fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if(colon && !strncmp(line, "model name", 10)) {
+            snprintf(cpu, len, "%s", colon + 2);
+            chomp_1(cpu);
+            break;
+        }
+    }
+    fclose(f);
+}
+void compiler_flags_1(char *flags, size_t len) {
+    if(BIGO_CFLAGS[0]) {
+        snprintf(flags, len, "%s", BIGO_CFLAGS);
+        return;
+    }
+    snprintf(flags, len, "%s%s%s%s%s",
+#ifdef __OPTIMIZE__
+            "-O",
+#else
+            "-O0",
+#endif
+#ifdef __AVX2__
+            " -mavx2",
+#else
+            "",
+#endif
+#ifdef __AVX512F__
+            " -mavx512f",
+#else
+            "",
+#endif
+#ifdef __FAST_MATH__
+            " -ffast-math",
+#else
+            "",
+#endif
+#ifdef __OPTIMIZE_SIZE__
+            " -Os"
+#else
+            ""
+#endif
+            );
+}
+/* [=] The commit we were built
+ * from - or failing that the one
+ * we're run in
+ */
+void git_hash_1(char *git, size_t len) {
+    FILE *p;
+
+    snprintf(git, len, "%s", BIGO_GIT_HASH[0] ? BIGO_GIT_HASH : "unknown");
+    if(BIGO_GIT_HASH[0]) return;
+    p = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+    if(!p) return;
+    if(fgets(git, len, p)) chomp_1(git);
+    if(pclose(p) || !git[0]) snprintf(git, len, "unknown");
+}
+void collect_run_meta() {
+    cpu_model_1(run_meta.cpu, sizeof(run_meta.cpu));
+#if defined(__clang__)
+    snprintf(run_meta.compiler, sizeof(run_meta.compiler), "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(run_meta.compiler, sizeof(run_meta.compiler), "gcc %s", __VERSION__);
+#else
+    snprintf(run_meta.compiler, sizeof(run_meta.compiler), "unknown");
+#endif
+    compiler_flags_1(run_meta.flags, sizeof(run_meta.flags));
+    git_hash_1(run_meta.git, sizeof(run_meta.git));
+}
+
+void json_str_1(char *s) {
+    putchar('"');
+    for(;*s;s++) {
+        if(*s == '"' || *s == '\\') putchar('\\');
+        if((unsigned char)*s >= ' ') putchar(*s);
+    }
+    putchar('"');
+}
+void csv_str_1(char *s) {
+    putchar('"');
+    for(;*s;s++) {
+        if(*s == '"') putchar('"');
+        putchar(*s);
+    }
+    putchar('"');
+}
+
+static int report_rows;
+
+/* [=] Start the output - the
+ * header of the csv or the
+ * opening of the json array
+ */
+void report_begin() {
+    if(options.format == TEXT_FORMAT) return;
+    collect_run_meta();
+    if(options.format == JSON_FORMAT) printf("[\n");
+    else printf("name,oclass,n,threads,status,samples,iters,min_ns,median_ns,mean_ns,p99_ns,stddev_ns,"
+                "queries_per_s,rss_bytes,peak_rss_bytes,ns_per_unit,unit,bytes_per_elem,to_device_ns,from_device_ns,gb_per_s,io_wait_pct,cycles,instructions,ipc,l1d_misses,llc_misses,"
+                "branch_misses,dtlb_misses,seed,distribution,cpu,compiler,flags,git\n");
+}
+void report_end() {
+    if(options.format == JSON_FORMAT) printf("%s]\n", report_rows ? "\n" : "");
+    fflush(stdout);
+}
+/* [=] One record. `status` is
+ * "ok", "not_executed" or
+ * "over_budget" - only "ok" ones
+ * have statistics.
+ */
+void report_row(struct environment *environment, struct stats *stats, char *status, int threads) {
+    int ok = !strcmp(status, "ok");
+    double qps = ok && environment->queries ? environment->queries / stats->median * 1e9 : 0;
+    double *counters = ok ? stats->counters : NULL;
+    char *unit;
+    double units = per_unit_1(environment, &unit);
+    double ipc = ok && counters[CYCLES] > 0 ? counters[INSTRUCTIONS] / counters[CYCLES] : 0;
+    int i;
+
+    if(options.format == JSON_FORMAT) {
+        printf("%s{\"name\": ", report_rows ? ",\n" : "");
+        json_str_1(environment->name);
+        printf(", \"oclass\": ");
+        json_str_1(oclass_1_str(environment->oclass));
+        printf(", \"n\": %ld, \"threads\": %d, \"status\": \"%s\"", environment->n, threads, status);
+        if(ok) {
+            printf(", \"samples\": %d, \"iters\": %ld, \"min_ns\": %.6g, \"median_ns\": %.6g, \"mean_ns\": %.6g"
+                   ", \"p99_ns\": %.6g, \"stddev_ns\": %.6g, \"queries_per_s\": %.6g"
+                   ", \"rss_bytes\": %ld, \"peak_rss_bytes\": %ld, \"ns_per_unit\": %.6g, \"unit\": \"%s\"",
+                   stats->samples, stats->iters, stats->min, stats->median, stats->mean,
+                   stats->p99, stats->stddev, qps, stats->rss, stats->peak_rss,
+                   stats->median / units, unit);
+            if(environment->bytes) printf(", \"bytes_per_elem\": %.4g", (double)environment->bytes / environment->n);
+            if(environment->to_device_ns || environment->from_device_ns) {
+                printf(", \"to_device_ns\": %lld, \"from_device_ns\": %lld", environment->to_device_ns, environment->from_device_ns);
+            }
+            if(environment->io_bytes) {
+                printf(", \"gb_per_s\": %.4g, \"io_wait_pct\": %.3g",
+                        environment->io_bytes / stats->median, 100.0 * environment->io_wait_ns / stats->median);
+            }
+            if(options.counters) {
+                for(i = 0;i < NUM_COUNTERS;i++) {
+                    printf(", \"%s\": ", counter_names[i]);
+                    if(counters[i] < 0) printf("null");
+                    else printf("%.6g", counters[i]);
+                    if(i == INSTRUCTIONS) {
+                        if(counters[CYCLES] > 0 && counters[INSTRUCTIONS] >= 0) printf(", \"ipc\": %.4g", ipc);
+                        else printf(", \"ipc\": null");
+                    }
+                }
+            }
+        }
+        printf(", \"seed\": %llu, \"distribution\": \"%s\", \"cpu\": ",
+                (unsigned long long)options.seed, distribution_1_str(options.distribution));
+        json_str_1(run_meta.cpu);
+        printf(", \"compiler\": ");
+        json_str_1(run_meta.compiler);
+        printf(", \"flags\": ");
+        json_str_1(run_meta.flags);
+        printf(", \"git\": ");
+        json_str_1(run_meta.git);
+        printf("}");
+    } else {
+        csv_str_1(environment->name);
+        printf(",");
+        csv_str_1(oclass_1_str(environment->oclass));
+        printf(",%ld,%d,%s,", environment->n, threads, status);
+        if(ok) {
+            printf("%d,%ld,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%ld,%ld,%.6g,%s",
+                   stats->samples, stats->iters, stats->min, stats->median, stats->mean,
+                   stats->p99, stats->stddev, qps, stats->rss, stats->peak_rss,
+                   stats->median / units, unit);
+            printf(",");
+            if(environment->bytes) printf("%.4g", (double)environment->bytes / environment->n);
+            printf(",");
+            if(environment->to_device_ns || environment->from_device_ns) {
+                printf("%lld,%lld", environment->to_device_ns, environment->from_device_ns);
+            } else {
+                printf(",");
+            }
+            printf(",");
+            if(environment->io_bytes) {
+                printf("%.4g,%.3g", environment->io_bytes / stats->median, 100.0 * environment->io_wait_ns / stats->median);
+            } else {
+                printf(",");
+            }
+        } else {
+            printf(",,,,,,,,,,,,,,,,");
+        }
+        for(i = 0;i < NUM_COUNTERS;i++) {
+            printf(",");
+            if(ok && options.counters && counters[i] >= 0) printf("%.6g", counters[i]);
+            if(i == INSTRUCTIONS) {
+                printf(",");
+                if(ok && options.counters && counters[CYCLES] > 0 && counters[INSTRUCTIONS] >= 0) printf("%.4g", ipc);
+            }
+        }
+        printf(",%llu,%s,", (unsigned long long)options.seed, distribution_1_str(options.distribution));
+        csv_str_1(run_meta.cpu);
+        printf(",");
+        csv_str_1(run_meta.compiler);
+        printf(",");
+        csv_str_1(run_meta.flags);
+        printf(",");
+        csv_str_1(run_meta.git);
+        printf("\n");
+    }
+    report_rows++;
+    fflush(stdout);
+}
+
+
+/* [=] Show a duration with a
+ * readable unit
+ */
+void show_time_msg_1(double ns) {
+    if(ns < 1e3) printf("%8.2fns", ns);
+    else if(ns < 1e6) printf("%8.2fus", ns / 1e3);
+    else if(ns < 1e9) printf("%8.2fms", ns / 1e6);
+    else printf("%8.2fs ", ns / 1e9);
+}
+/* [=] Show a size in memory
+ * with a readable unit
+ */
+void show_bytes_msg_1(double bytes) {
+    if(bytes < 1024) printf("%.0fB", bytes);
+    else if(bytes < 1024*1024) printf("%.1fKB", bytes / 1024);
+    else if(bytes < 1024*1024*1024) printf("%.1fMB", bytes / (1024*1024));
+    else printf("%.2fGB", bytes / (1024*1024*1024));
+}
+/* [=] Re-run a parallel
+ * environment with 1, 2, 4...
+ * threads and show the speedup
+ * over one thread
+ */
+void show_thread_scaling(struct environment* environment) {
+    struct pool *saved = bench_pool;
+    double single = 0;
+    int threads;
+
+    for(threads = 1;;threads *= 2) {
+        struct stats stats;
+
+        if(threads > options.threads) threads = options.threads;
+        bench_pool = pool_create(threads);
+        stats = bench_environment(environment);
+        pool_destroy(bench_pool);
+        if(threads == 1) single = stats.median;
+
+        if(options.format != TEXT_FORMAT) {
+            report_row(environment, &stats, stats.over_budget ? "over_budget" : "ok", threads);
+            if(threads == options.threads) break;
+            continue;
+        }
+        printf("%36s%3d threads: ", "", threads);
+        if(stats.over_budget || !single) {
+            printf("> budget (%gs)\n", options.budget);
+        } else {
+            printf("median ");
+            show_time_msg_1(stats.median);
+            printf("  speedup %5.2fx\n", single / stats.median);
+        }
+        if(threads == options.threads) break;
+    }
+    bench_pool = saved;
+}
+/* [=] Show the counters per
+ * call under the timings
+ */
+void show_counter_1(char *name, double val) {
+    if(val < 0) printf("  %s -", name);
+    else if(val < 100) printf("  %s %.2f", name, val);
+    else printf("  %s %.4g", name, val);
+}
+void show_counters_1(struct stats *stats) {
+    double *c = stats->counters;
+
+    printf("%36s per call:", "");
+    show_counter_1("cycles", c[CYCLES]);
+    show_counter_1("instr", c[INSTRUCTIONS]);
+    show_counter_1("IPC", c[CYCLES] > 0 && c[INSTRUCTIONS] >= 0 ? c[INSTRUCTIONS] / c[CYCLES] : -1);
+    show_counter_1("L1d miss", c[L1D_MISSES]);
+    show_counter_1("LLC miss", c[LLC_MISSES]);
+    show_counter_1("br miss", c[BRANCH_MISSES]);
+    show_counter_1("dTLB miss", c[DTLB_MISSES]);
+    printf("\n");
+}
+/* [=] Show an environment the
+ * sweep did not run because it
+ * would not fit in its budget
+ */
+void show_skipped(struct environment* environment, double estimate) {
+    if(options.format != TEXT_FORMAT) {
+        report_row(environment, NULL, "over_budget", options.threads);
+        return;
+    }
+    printf("%-12s%-24s(%ld items): > budget (%gs)",
+            oclass_1_str(environment->oclass),
+            environment->name,
+            environment->n,
+            options.budget);
+    if(estimate > 0) printf(" - estimated %.3gs", estimate);
+    printf("\n");
+}
+/* [=] The start of a text row */
+void show_row_head_1(struct environment* environment) {
+    printf("%-12s%-24s(%ld items): ",
+            oclass_1_str(environment->oclass),
+            environment->name,
+            environment->n);
+}
+/* [=] The rest of a text row
+ * (and the thread scaling of
+ * parallel ones)
+ */
+void show_stats_1(struct environment* environment, struct stats *stats) {
+    if(stats->over_budget) {
+        printf("> budget (%gs)\n", options.budget);
+        return;
+    }
+
+    printf("min ");
+    show_time_msg_1(stats->min);
+    printf("  median ");
+    show_time_msg_1(stats->median);
+    printf("  p99 ");
+    show_time_msg_1(stats->p99);
+    printf("  stddev ");
+    show_time_msg_1(stats->stddev);
+    printf("  (%dx%ld)", stats->samples, stats->iters);
+    if(environment->queries) printf("  %.3f Mq/s", environment->queries / stats->median * 1e3);
+    if(options.per_unit) {
+        char *unit;
+        double units = per_unit_1(environment, &unit);
+        printf("  %.3f ns/%s", stats->median / units, unit);
+    }
+    if(environment->bytes) printf("  %.2f B/elem", (double)environment->bytes / environment->n);
+    if(environment->to_device_ns || environment->from_device_ns) {
+        printf("  transfer in ");
+        show_time_msg_1(environment->to_device_ns);
+        printf(" out ");
+        show_time_msg_1(environment->from_device_ns);
+    }
+    if(stats->peak_rss) {
+        printf("  rss ");
+        show_bytes_msg_1(stats->peak_rss);
+        if(stats->peak_rss > stats->rss) {
+            printf(" (+");
+            show_bytes_msg_1(stats->peak_rss - stats->rss);
+            printf(")");
+        }
+    }
+    printf("\n");
+    if(options.counters) show_counters_1(stats);
+
+    if(environment->parallel && options.threads > 1) show_thread_scaling(environment);
+}
+/* [=] Show statistics measured
+ * earlier (by the concurrent
+ * runner)
+ */
+void show_stats(struct environment* environment, struct stats *stats) {
+    if(options.format != TEXT_FORMAT) {
+        report_row(environment, stats, stats->over_budget ? "over_budget" : "ok", options.threads);
+        if(environment->parallel && options.threads > 1) show_thread_scaling(environment);
+        return;
+    }
+    show_row_head_1(environment);
+    show_stats_1(environment, stats);
+}
+/* [=] Benchmark the algorithm
+ * and show the statistics.
+ * Returns samples = 0 if not
+ * executed.
+ */
+struct stats show_time_taken(struct environment* environment) {
+    struct stats stats;
+
+    if(!environment->data) {
+        stats.samples = 0;
+        stats.over_budget = 0;
+        if(options.format != TEXT_FORMAT) {
+            report_row(environment, &stats, "not_executed", options.threads);
+            return stats;
+        }
+        show_row_head_1(environment);
+        printf("(Not executed)\n");
+        return stats;
+    }
+
+    if(options.format != TEXT_FORMAT) {
+        stats = bench_environment(environment);
+        show_stats(environment, &stats);
+        return stats;
+    }
+
+    show_row_head_1(environment);
+    fflush(stdout);
+    stats = bench_environment(environment);
+    show_stats_1(environment, &stats);
+    return stats;
+}
+
+/* How much each task fills when
+ * making the arrays.
+ */
+#define FILL_GRAIN (1L << 16)
+/* The values few_unique arrays
+ * are made of, and the skew of
+ * the zipf ones.
+ */
+#define FEW_UNIQUE 16
+#define QUICK_SORT_SAFE_SZ (1L << 14)
+#define ZIPF_S 1.1
+struct fill {
+    int *array;
+    long sz;
+    uint64_t seed;
+    enum distribution distribution;
+};
+/* [=] Item `i` depends only on
+ * the seed and `i` - never on
+ * which thread made it
+ */
+void fill_1(struct task *task) {
+    struct fill *fill = task->data;
+    long i;
+
+    for(i = task->low;i < task->high;i++) {
+        int *val = &fill->array[i];
+        switch(fill->distribution) {
+            case UNIFORM:
+                *val = random_int_at(fill->seed, i);
+                break;
+            case SORTED:
+                *val = (int)((double)i / fill->sz * RAND_MAX);
+                break;
+            case REVERSED:
+                *val = (int)((double)(fill->sz - 1 - i) / fill->sz * RAND_MAX);
+                break;
+            case FEW_UNIQUE_VALUES:
+                *val = (int)(random_at(fill->seed, i) % FEW_UNIQUE) * (RAND_MAX / FEW_UNIQUE);
+                break;
+            case ZIPF: {
+                /* invert the (continuous)
+                 * zipf CDF over ranks
+                 * 1..sz */
+                double u = (random_at(fill->seed, i) >> 11) * (1.0 / 9007199254740992.0);
+                double rank = pow((pow(fill->sz, 1 - ZIPF_S) - 1) * u + 1, 1 / (1 - ZIPF_S));
+                *val = (int)(rank < fill->sz ? rank : fill->sz) - 1;
+                break;
+            }
+        }
+    }
+}
+/* [=] Return a large array of
+ * the chosen distribution, made
+ * in parallel
+ */
+int* create_int_array(long sz, uint64_t seed) {
+    struct fill fill;
+    atomic_long pending;
+    struct task task;
+    long i;
+
+    fill.array = arena_alloc(sz*sizeof(int));
+    fill.sz = sz;
+    fill.seed = seed;
+    fill.distribution = options.distribution;
+
+    atomic_init(&pending, 0);
+    task.run = &fill_1;
+    task.data = &fill;
+    task.pending = &pending;
+    for(i = 0;i < sz;i += FILL_GRAIN) {
+        task.low = i;
+        task.high = i + FILL_GRAIN < sz ? i + FILL_GRAIN : sz;
+        pool_submit(bench_pool, &task);
+    }
+    pool_wait(bench_pool, &pending);
+    return fill.array;
+}
+
+/* (datasets) */
+
+/* The read-only inputs all the
+ * environments of a size share:
+ * the input array and a sorted
+ * copy of it. Making (and
+ * especially sorting) them is
+ * slow for big sizes so with
+ * --cache they are saved to a
+ * file the next run maps back
+ * in for free.
+ */
+struct dataset {
+    struct array input;
+    struct array sorted;
+};
+
+/* The file is a header page
+ * followed by the input then
+ * the sorted values.
+ */
+#define DATASET_MAGIC 0x3154455347494200ULL
+#define DATASET_HEADER 4096
+struct dataset_header {
+    uint64_t magic;
+    int64_t sz;
+    uint64_t seed;
+    int64_t distribution;
+};
+
+void dataset_path_1(char *path, size_t len, long sz) {
+    snprintf(path, len, "%s/bigo-%ld-%llu-%s.dat",
+            options.cache, sz, (unsigned long long)options.seed,
+            distribution_1_str(options.distribution));
+}
+
+/* [=] Map a cached dataset.
+ * Returns 0 if there isn't one
+ * (or it doesn't match).
+ */
+int dataset_map_1(struct dataset *ds, long sz) {
+    char path[4096];
+    struct stat st;
+    struct dataset_header *header;
+    size_t bytes = DATASET_HEADER + 2*sz*sizeof(int);
+    char *map;
+    int fd;
+
+    dataset_path_1(path, sizeof(path), sz);
+    fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    if(fstat(fd, &st) || (size_t)st.st_size != bytes) {
+        close(fd);
+        return 0;
+    }
+    map = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return 0;
+
+    header = (struct dataset_header*)map;
+    if(header->magic != DATASET_MAGIC
+            || header->sz != sz
+            || header->seed != options.seed
+            || header->distribution != options.distribution) {
+        munmap(map, bytes);
+        return 0;
+    }
+    if(bench_arena) arena_adopt(bench_arena, map, bytes);
+#ifdef MADV_HUGEPAGE
+    madvise(map, bytes, MADV_HUGEPAGE);
+#endif
+    madvise(map, bytes, MADV_WILLNEED);
+
+    ds->input.sz = sz;
+    ds->input.vals = (int*)(map + DATASET_HEADER);
+    ds->sorted.sz = sz;
+    ds->sorted.vals = ds->input.vals + sz;
+    return 1;
+}
+
+int dataset_write_1(int fd, void *p, size_t bytes) {
+    char *c = p;
+    while(bytes) {
+        ssize_t w = write(fd, c, bytes);
+        if(w < 0 && errno == EINTR) continue;
+        if(w <= 0) return 0;
+        c += w;
+        bytes -= w;
+    }
+    return 1;
+}
+
+/* [=] Save a dataset for later
+ * runs. It's written under a
+ * temporary name and renamed so
+ * a half written file is never
+ * mapped.
+ */
+void dataset_save_1(struct dataset *ds) {
+    char path[4096], tmp[4160];
+    char header[DATASET_HEADER] = {0};
+    struct dataset_header *h = (struct dataset_header*)header;
+    long sz = ds->input.sz;
+    int fd, ok;
+
+    h->magic = DATASET_MAGIC;
+    h->sz = sz;
+    h->seed = options.seed;
+    h->distribution = options.distribution;
+
+    mkdir(options.cache, 0777);
+    dataset_path_1(path, sizeof(path), sz);
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+    fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fd < 0) {
+        fprintf(stderr, "cannot cache dataset in %s: %s\n", tmp, strerror(errno));
+        return;
+    }
+    ok = dataset_write_1(fd, header, sizeof(header))
+        && dataset_write_1(fd, ds->input.vals, sz*sizeof(int))
+        && dataset_write_1(fd, ds->sorted.vals, sz*sizeof(int));
+    ok = !close(fd) && ok;
+    if(!ok || rename(tmp, path)) {
+        fprintf(stderr, "cannot cache dataset in %s: %s\n", path, strerror(errno));
+        unlink(tmp);
+    }
+}
+
+/* [=] The dataset for a size -
+ * from the cache if we can,
+ * otherwise made (and cached)
+ */
+struct dataset* create_dataset(long sz, uint64_t seed) {
+    struct dataset *ds = arena_alloc(sizeof(struct dataset));
+
+    if(options.cache && dataset_map_1(ds, sz)) return ds;
+
+    ds->input.sz = sz;
+    ds->input.vals = create_int_array(sz, seed);
+    ds->sorted.sz = sz;
+    ds->sorted.vals = arena_alloc(sz*sizeof(int));
+    memcpy(ds->sorted.vals, ds->input.vals, sz*sizeof(int));
+    options.sort->sort(&ds->sorted);
+
+    if(options.cache) dataset_save_1(ds);
+    return ds;
+}
+
+/* [=] Refresh a mutable array
+ * from its pristine copy
+ */
+void copy_array(struct array_copy *copy) {
+    memcpy(copy->to->vals, copy->from->vals, sizeof(int)*copy->from->sz);
+}
+void copy_array_hook(void *copy) {
+    copy_array(copy);
+}
+
+/* [=] dummy function
+ * for not implemented
+ * algorithms.
+ */
+void do_nothing(void* data) {
+}
+
+/* (registry) */
+
+/* The inputs for one size. Each
+ * is made the first time an
+ * algorithm asks for it so we
+ * only pay for what runs. They
+ * get their own random streams
+ * so they come out the same
+ * whichever algorithms run.
+ */
+struct inputs {
+    long sz;
+    uint64_t seed;
+    struct dataset *dataset;
+    struct array *mutable_array;
+    struct array_copy *mutable_copy;
+    struct radix_sort *radix;
+    struct search *search;
+    struct eytzinger *eytzinger;
+    struct batch_search *batch;
+    struct range_sum *rs;
+    struct range_ops *range_ops;
+    struct range_stream *sqrt_stream;
+    struct range_stream *fenwick_stream;
+    struct range_stream *sparse_stream;
+    struct range_batch *range_batch;
+    struct tsp *tsp;
+    struct max_seq *max_seq;
+    struct search_i32 *search_i32;
+    struct search_i64 *search_i64;
+    struct search_f32 *search_f32;
+    struct packed_search *packed;
+};
+enum input_stream {
+    SEARCH_STREAM = 1,
+    BATCH_STREAM,
+    RANGE_SUM_STREAM,
+    RANGE_OPS_STREAM,
+    RANGE_BATCH_STREAM,
+    TSP_STREAM,
+};
+
+struct array* need_array(struct inputs *in) {
+    if(!in->dataset) in->dataset = create_dataset(in->sz, in->seed);
+    return &in->dataset->input;
+}
+struct array* need_sorted_array(struct inputs *in) {
+    need_array(in);
+    return &in->dataset->sorted;
+}
+/* [=] Sorting changes the array
+ * so each run sorts a fresh
+ * copy of the same input
+ */
+struct array_copy* need_mutable_copy(struct inputs *in) {
+    if(!in->mutable_copy) {
+        in->mutable_array = arena_alloc(sizeof(struct array));
+        in->mutable_array->sz = in->sz;
+        in->mutable_array->vals = arena_alloc(in->sz*sizeof(int));
+        in->mutable_copy = arena_alloc(sizeof(struct array_copy));
+        in->mutable_copy->from = need_array(in);
+        in->mutable_copy->to = in->mutable_array;
+    }
+    return in->mutable_copy;
+}
+struct radix_sort* need_radix(struct inputs *in) {
+    if(!in->radix) {
+        need_mutable_copy(in);
+        in->radix = arena_alloc(sizeof(struct radix_sort));
+        in->radix->array = in->mutable_array;
+        in->radix->scratch = arena_alloc(in->sz*sizeof(int));
+    }
+    return in->radix;
+}
+/* Set by --verify to look for
+ * a needle below the smallest
+ * item - so not there - instead
+ * of one from the haystack.
+ */
+static int absent_needle;
+
+struct search* need_search(struct inputs *in) {
+    if(!in->search) {
+        struct rng rng = rng_create(in->seed, SEARCH_STREAM);
+        in->search = arena_alloc(sizeof(struct search));
+        in->search->haystack = need_sorted_array(in);
+        in->search->needle = in->search->haystack->vals[rng_below(&rng, in->sz)];
+        if(absent_needle) in->search->needle = in->search->haystack->vals[0] > 0 ? -1 : INT_MIN;
+    }
+    return in->search;
+}
+/* [=] The same search on each
+ * element type */
+#define NEED_TYPED_SEARCH(suffix) \
+    struct search_##suffix* need_search_##suffix(struct inputs *in) { \
+        if(!in->search_##suffix) in->search_##suffix = create_search_##suffix(need_search(in)); \
+        return in->search_##suffix; \
+    }
+NEED_TYPED_SEARCH(i32)
+NEED_TYPED_SEARCH(i64)
+NEED_TYPED_SEARCH(f32)
+struct packed_search* need_packed(struct inputs *in) {
+    if(!in->packed) in->packed = create_packed_search(need_search(in));
+    return in->packed;
+}
+struct eytzinger* need_eytzinger(struct inputs *in) {
+    if(!in->eytzinger) in->eytzinger = eytzinger_build(need_search(in));
+    return in->eytzinger;
+}
+struct batch_search* need_batch(struct inputs *in) {
+    if(!in->batch) {
+        struct rng rng = rng_create(in->seed, BATCH_STREAM);
+        in->batch = create_batch_search(need_sorted_array(in), options.batch, &rng);
+    }
+    return in->batch;
+}
+struct range_sum* need_range_sum(struct inputs *in) {
+    if(!in->rs) {
+        struct rng rng = rng_create(in->seed, RANGE_SUM_STREAM);
+        struct range_sum *rs = arena_alloc(sizeof(struct range_sum));
+        rs->array = need_array(in);
+        parallel_setup_slice_sums(rs, options.slice);
+        rs->from = rng_below(&rng, rs->array->sz);
+        rs->to = rng_below(&rng, rs->array->sz);
+        if(rs->from > rs->to) {
+            long tmp = rs->from;
+            rs->from = rs->to;
+            rs->to = tmp;
+        }
+        in->rs = rs;
+    }
+    return in->rs;
+}
+struct range_ops* need_range_ops(struct inputs *in) {
+    if(!in->range_ops) {
+        struct rng rng = rng_create(in->seed, RANGE_OPS_STREAM);
+        in->range_ops = create_range_ops(in->sz, options.range_ops, options.updates, &rng);
+    }
+    return in->range_ops;
+}
+struct range_stream* need_sqrt_stream(struct inputs *in) {
+    if(!in->sqrt_stream) in->sqrt_stream = create_sqrt_stream(need_array(in), need_range_ops(in), options.slice);
+    return in->sqrt_stream;
+}
+struct range_stream* need_fenwick_stream(struct inputs *in) {
+    if(!in->fenwick_stream) in->fenwick_stream = create_fenwick_stream(need_array(in), need_range_ops(in));
+    return in->fenwick_stream;
+}
+struct range_stream* need_sparse_stream(struct inputs *in) {
+    if(!in->sparse_stream) in->sparse_stream = create_sparse_stream(need_array(in), need_range_ops(in));
+    return in->sparse_stream;
+}
+struct range_batch* need_range_batch(struct inputs *in) {
+    if(!in->range_batch) {
+        struct rng rng = rng_create(in->seed, RANGE_BATCH_STREAM);
+        in->range_batch = create_range_batch(need_range_sum(in), create_range_ops(in->sz, options.range_ops, 0, &rng));
+    }
+    return in->range_batch;
+}
+struct tsp* need_tsp(struct inputs *in) {
+    if(!in->tsp && in->sz <= HELD_KARP_MAX) {
+        struct rng rng = rng_create(in->seed, TSP_STREAM);
+        in->tsp = create_tsp(in->sz, &rng);
+    }
+    return in->tsp;
+}
+struct max_seq* need_max_seq(struct inputs *in) {
+    if(!in->max_seq) {
+        in->max_seq = arena_alloc(sizeof(struct max_seq));
+        in->max_seq->array = need_array(in);
+    }
+    return in->max_seq;
+}
+
+/* [=] Cross check the engines
+ * whose inputs got made
+ */
+void check_inputs(struct inputs *in) {
+    if(in->sqrt_stream && in->fenwick_stream) check_range_streams(in->sqrt_stream, in->fenwick_stream, in->sparse_stream);
+    if(in->range_batch) check_range_batch(in->range_batch);
+    if(in->tsp && in->sz <= TSP_CHECK_MAX) check_tsp(in->tsp);
+    if(in->max_seq) check_max_seq_sums(in->max_seq);
+}
+
+/* An algorithm as registered:
+ * `setup` fills in the
+ * environment for a size (data
+ * NULL means it doesn't run at
+ * that size) and `teardown`
+ * undoes anything it did that
+ * releasing the arena won't.
+ * `parallel` ones run on
+ * `bench_pool`.
+ */
+typedef void (*setup_func)(struct environment*, struct inputs*);
+
+/* [=] Make the kernel for an
+ * algorithm taking a `type*`.
+ * The loop is inside the timed
+ * region and calls the
+ * algorithm directly (so it can
+ * be inlined) - the only
+ * indirect call is the one into
+ * the kernel per sample.
+ */
+#define KERNEL(algo, type) \
+    void algo##_kernel(void* data, long iters) { \
+        type *d = data; \
+        long k; \
+        for(k = 0;k < iters;k++) algo(d); \
+    }
+KERNEL(get_first, struct array)
+KERNEL(binary_jump_search, struct search)
+KERNEL(packed_binary_search, struct packed_search)
+KERNEL(packed_linear_search, struct packed_search)
+KERNEL(branchless_search, struct search)
+KERNEL(branchless_search_i32, struct search_i32)
+KERNEL(branchless_search_i64, struct search_i64)
+KERNEL(branchless_search_f32, struct search_f32)
+KERNEL(eytzinger_search, struct eytzinger)
+KERNEL(batch_binary_loop, struct batch_search)
+KERNEL(batch_binary_search, struct batch_search)
+KERNEL(range_sum_query, struct range_sum)
+KERNEL(sqrt_range_stream, struct range_stream)
+KERNEL(fenwick_range_stream, struct range_stream)
+KERNEL(sparse_range_stream, struct range_stream)
+KERNEL(range_sum_loop, struct range_batch)
+KERNEL(range_batch_sums, struct range_batch)
+KERNEL(linear_search, struct search)
+KERNEL(linear_search_i32, struct search_i32)
+KERNEL(linear_search_i64, struct search_i64)
+KERNEL(linear_search_f32, struct search_f32)
+KERNEL(simd_linear_search, struct search)
+KERNEL(scalar_linear_search, struct search)
+KERNEL(batch_linear_loop, struct batch_search)
+KERNEL(batch_linear_search, struct batch_search)
+KERNEL(quick_sort, struct array)
+KERNEL(intro_sort, struct array)
+KERNEL(parallel_quick_sort, struct array)
+KERNEL(radix_sort, struct radix_sort)
+KERNEL(find_max_seq_sum, struct array)
+KERNEL(kadane_max_seq_sum, struct max_seq)
+KERNEL(simd_max_seq_sum, struct max_seq)
+KERNEL(parallel_max_seq_sum, struct max_seq)
+KERNEL(solve_hanoi, struct hanoi)
+KERNEL(gray_code_hanoi, struct hanoi)
+KERNEL(tsp_brute_force, struct tsp)
+KERNEL(tsp_held_karp, struct tsp)
+KERNEL(slice_sums_build, struct range_sum)
+#ifdef BIGO_OFFLOAD
+KERNEL(offload_linear_search, struct offload_search)
+KERNEL(offload_slice_sums, struct offload_slices)
+KERNEL(offload_max_seq_sum, struct offload_max_seq)
+KERNEL(offload_radix_sort, struct offload_sort)
+#endif
+KERNEL(do_nothing, void)
+
+struct algorithm {
+    char *name;
+    enum OClass oclass;
+    kernel run;
+    setup_func setup;
+    func teardown;
+    int parallel;
+};
+struct registry {
+    struct algorithm *algorithms;
+    int num;
+    int cap;
+};
+static struct registry registry;
+
+/* [=] Add an algorithm - they
+ * run in the order registered
+ */
+struct algorithm* register_algorithm(char *name, enum OClass oclass, kernel run, setup_func setup, func teardown) {
+    struct algorithm *algorithm;
+
+    if(registry.num == registry.cap) {
+        registry.cap = registry.cap ? registry.cap*2 : 16;
+        registry.algorithms = realloc(registry.algorithms, sizeof(struct algorithm)*registry.cap);
+    }
+    algorithm = &registry.algorithms[registry.num++];
+    algorithm->name = name;
+    algorithm->oclass = oclass;
+    algorithm->run = run;
+    algorithm->setup = setup;
+    algorithm->teardown = teardown;
+    algorithm->parallel = 0;
+    return algorithm;
+}
+
+/* [=] Keep only the algorithms
+ * whose name or class matches
+ * the pattern. Returns 0 on a
+ * bad pattern.
+ */
+int filter_algorithms(char *pattern) {
+    regex_t re;
+    int i, num = 0;
+
+    if(regcomp(&re, pattern, REG_EXTENDED|REG_NOSUB)) return 0;
+    for(i = 0;i < registry.num;i++) {
+        struct algorithm *algorithm = &registry.algorithms[i];
+        if(!regexec(&re, algorithm->name, 0, NULL, 0)
+                || !regexec(&re, oclass_1_str(algorithm->oclass), 0, NULL, 0)) {
+            registry.algorithms[num++] = *algorithm;
+        }
+    }
+    registry.num = num;
+    regfree(&re);
+    return 1;
+}
+
+/* [=] Setups for the algorithms.
+ * Those sharing inputs share a
+ * setup.
+ */
+void setup_array(struct environment *e, struct inputs *in) {
+    e->data = need_array(in);
+}
+void setup_search(struct environment *e, struct inputs *in) {
+    e->data = need_search(in);
+    e->bytes = in->sz*sizeof(int);
+}
+void setup_search_i32(struct environment *e, struct inputs *in) {
+    e->data = need_search_i32(in);
+    e->bytes = in->sz*sizeof(int32_t);
+}
+void setup_search_i64(struct environment *e, struct inputs *in) {
+    e->data = need_search_i64(in);
+    e->bytes = in->sz*sizeof(int64_t);
+}
+void setup_search_f32(struct environment *e, struct inputs *in) {
+    e->data = need_search_f32(in);
+    e->bytes = in->sz*sizeof(float);
+}
+void setup_packed_search(struct environment *e, struct inputs *in) {
+    struct packed_search *packed = need_packed(in);
+    e->data = packed;
+    e->bytes = packed->haystack->bytes;
+}
+/* [=] The build on its own copy
+ * so it never races with the
+ * queries over `need_range_sum` */
+void setup_slice_sums_build(struct environment *e, struct inputs *in) {
+    struct range_sum *rs = arena_alloc(sizeof(struct range_sum));
+    rs->array = need_array(in);
+    parallel_setup_slice_sums(rs, options.slice);
+    e->data = rs;
+}
+void setup_eytzinger(struct environment *e, struct inputs *in) {
+    e->data = need_eytzinger(in);
+}
+void setup_batch(struct environment *e, struct inputs *in) {
+    struct batch_search *batch = need_batch(in);
+    e->data = batch;
+    e->queries = batch->num;
+    e->exclusive = batch;
+}
+void setup_range_sum(struct environment *e, struct inputs *in) {
+    e->data = need_range_sum(in);
+}
+void setup_sqrt_stream(struct environment *e, struct inputs *in) {
+    e->data = need_sqrt_stream(in);
+    e->queries = need_range_ops(in)->num;
+}
+void setup_fenwick_stream(struct environment *e, struct inputs *in) {
+    e->data = need_fenwick_stream(in);
+    e->queries = need_range_ops(in)->num;
+}
+void setup_sparse_stream(struct environment *e, struct inputs *in) {
+    e->data = need_sparse_stream(in);
+    e->queries = need_range_ops(in)->num;
+}
+void setup_range_batch(struct environment *e, struct inputs *in) {
+    struct range_batch *range_batch = need_range_batch(in);
+    e->data = range_batch;
+    e->queries = range_batch->ops->num;
+    e->exclusive = range_batch;
+}
+/* [=] NAN (which matches
+ * nothing) if out of order,
+ * else a hash of the array */
+double digest_array_1(struct array *array) {
+    uint64_t h = 0;
+    long i;
+
+    for(i = 0;i < array->sz;i++) {
+        if(i && array->vals[i-1] > array->vals[i]) return NAN;
+        h = splitmix64_1(h ^ (unsigned)array->vals[i]);
+    }
+    /* fits a double exactly */
+    return (double)(h >> 11);
+}
+double digest_sorted_1(struct environment *e) {
+    return digest_array_1(((struct array_copy*)e->fixture)->to);
+}
+void setup_sort(struct environment *e, struct inputs *in) {
+    e->fixture = need_mutable_copy(in);
+    e->setup = &copy_array_hook;
+    e->digest = &digest_sorted_1;
+    e->data = in->mutable_array;
+    e->exclusive = in->mutable_array;
+}
+/* [=] quick_sort recurses once
+ * per item on sorted or
+ * repetitive input so only runs
+ * where that won't blow the
+ * stack
+ */
+void setup_quick_sort(struct environment *e, struct inputs *in) {
+    if(options.distribution == UNIFORM || in->sz <= QUICK_SORT_SAFE_SZ) setup_sort(e, in);
+}
+void setup_radix_sort(struct environment *e, struct inputs *in) {
+    setup_sort(e, in);
+    e->data = need_radix(in);
+}
+void setup_max_seq(struct environment *e, struct inputs *in) {
+    e->data = need_max_seq(in);
+    e->exclusive = e->data;
+}
+void setup_hanoi(struct environment *e, struct inputs *in) {
+    if(in->sz <= HANOI_MAX_DISKS) e->data = create_hanoi(in->sz, 0);
+}
+void setup_hanoi_moves(struct environment *e, struct inputs *in) {
+    if(in->sz <= HANOI_MAX_DISKS) e->data = create_hanoi(in->sz, HANOI_BATCH);
+}
+void setup_tsp_brute_force(struct environment *e, struct inputs *in) {
+    if(in->sz <= TSP_BRUTE_MAX) e->data = need_tsp(in);
+    e->exclusive = e->data;
+}
+void setup_tsp(struct environment *e, struct inputs *in) {
+    e->data = need_tsp(in);
+    e->exclusive = e->data;
+}
+void setup_nothing(struct environment *e, struct inputs *in) {
+    UNUSED(e);
+    UNUSED(in);
+}
+#ifdef BIGO_OFFLOAD
+/* [=] --verify: bring the sorted
+ * items back to check them */
+double digest_offload_sort_1(struct environment *e) {
+    struct offload_sort *os = e->data;
+    struct array array;
+    double digest;
+
+    array.sz = os->sz;
+    array.vals = malloc(sizeof(int)*os->sz);
+    omp_target_memcpy(array.vals, os->work, sizeof(int)*os->sz, 0, 0, omp_get_initial_device(), omp_get_default_device());
+    digest = digest_array_1(&array);
+    free(array.vals);
+    return digest;
+}
+/* [=] The offload rows show
+ * their copies apart from the
+ * timing */
+void setup_offload_1(struct environment *e, void *data) {
+    struct offload *o = data;
+    e->data = data;
+    if(!o) return;
+    e->to_device_ns = o->to_device_ns;
+    e->from_device_ns = o->from_device_ns;
+}
+void setup_offload_search(struct environment *e, struct inputs *in) {
+    setup_offload_1(e, create_offload_search(need_search(in)));
+}
+void setup_offload_slices(struct environment *e, struct inputs *in) {
+    setup_offload_1(e, create_offload_slices(need_array(in), options.slice));
+}
+void setup_offload_max_seq(struct environment *e, struct inputs *in) {
+    setup_offload_1(e, create_offload_max_seq(need_array(in)));
+}
+void setup_offload_sort(struct environment *e, struct inputs *in) {
+    setup_offload_1(e, create_offload_sort(need_array(in)));
+    e->fixture = e->data;
+    e->setup = &offload_sort_reset;
+    e->digest = &digest_offload_sort_1;
+}
+#endif
+
+/* [=] Register all the
+ * algorithms we know
+ */
+void register_algorithms() {
+    /* O(1) */
+    register_algorithm("get_first", O1, &get_first_kernel, &setup_array, NULL);
+    /* O(log(n)) */
+    register_algorithm("binary_jump_search", O_logn, &binary_jump_search_kernel, &setup_search, NULL);
+    register_algorithm("packed_binary_search", O_logn, &packed_binary_search_kernel, &setup_packed_search, NULL);
+    register_algorithm("branchless_search", O_logn, &branchless_search_kernel, &setup_search, NULL);
+    register_algorithm("branchless_search_i32", O_logn, &branchless_search_i32_kernel, &setup_search_i32, NULL);
+    register_algorithm("branchless_search_i64", O_logn, &branchless_search_i64_kernel, &setup_search_i64, NULL);
+    register_algorithm("branchless_search_f32", O_logn, &branchless_search_f32_kernel, &setup_search_f32, NULL);
+    register_algorithm("eytzinger_search", O_logn, &eytzinger_search_kernel, &setup_eytzinger, NULL);
+    register_algorithm("batch_binary_loop", O_logn, &batch_binary_loop_kernel, &setup_batch, NULL);
+    register_algorithm("batch_binary_search", O_logn, &batch_binary_search_kernel, &setup_batch, NULL);
+    /* O(sqrt(n)) */
+    register_algorithm("range_sum_query", O_sqrtn, &range_sum_query_kernel, &setup_range_sum, NULL);
+    register_algorithm("sqrt_range_stream", O_sqrtn, &sqrt_range_stream_kernel, &setup_sqrt_stream, NULL);
+    register_algorithm("fenwick_range_stream", O_logn, &fenwick_range_stream_kernel, &setup_fenwick_stream, NULL);
+    register_algorithm("sparse_range_stream", O1, &sparse_range_stream_kernel, &setup_sparse_stream, NULL);
+    register_algorithm("range_sum_loop", O_sqrtn, &range_sum_loop_kernel, &setup_range_batch, NULL);
+    register_algorithm("range_batch_sums", O_sqrtn, &range_batch_sums_kernel, &setup_range_batch, NULL)->parallel = 1;
+    /* O(n) */
+    register_algorithm("linear_search", O_n, &linear_search_kernel, &setup_search, NULL);
+    register_algorithm("linear_search_i32", O_n, &linear_search_i32_kernel, &setup_search_i32, NULL);
+    register_algorithm("linear_search_i64", O_n, &linear_search_i64_kernel, &setup_search_i64, NULL);
+    register_algorithm("linear_search_f32", O_n, &linear_search_f32_kernel, &setup_search_f32, NULL);
+    register_algorithm("packed_linear_search", O_n, &packed_linear_search_kernel, &setup_packed_search, NULL);
+    register_algorithm("find_first_scalar", O_n, &scalar_linear_search_kernel, &setup_search, NULL);
+    register_algorithm(find_first_engine.name, O_n, &simd_linear_search_kernel, &setup_search, NULL);
+#ifdef BIGO_OFFLOAD
+    register_algorithm("offload_linear_search", O_n, &offload_linear_search_kernel, &setup_offload_search, &offload_release)->parallel = 1;
+#endif
+    register_algorithm("batch_linear_loop", O_n, &batch_linear_loop_kernel, &setup_batch, NULL);
+    register_algorithm("batch_linear_search", O_n, &batch_linear_search_kernel, &setup_batch, NULL);
+#ifdef BIGO_OFFLOAD
+    register_algorithm("slice_sums_build", O_n, &slice_sums_build_kernel, &setup_slice_sums_build, NULL)->parallel = 1;
+    register_algorithm("offload_slice_sums", O_n, &offload_slice_sums_kernel, &setup_offload_slices, &offload_release)->parallel = 1;
+#endif
+    /* O(nlog(n)) */
+    register_algorithm("quick_sort", O_nlogn, &quick_sort_kernel, &setup_quick_sort, NULL);
+    register_algorithm("intro_sort", O_nlogn, &intro_sort_kernel, &setup_sort, NULL);
+    register_algorithm("parallel_quick_sort", O_nlogn, &parallel_quick_sort_kernel, &setup_quick_sort, NULL)->parallel = 1;
+    register_algorithm("radix_sort", O_n, &radix_sort_kernel, &setup_radix_sort, NULL);
+#ifdef BIGO_OFFLOAD
+    register_algorithm("offload_radix_sort", O_n, &offload_radix_sort_kernel, &setup_offload_sort, &offload_release)->parallel = 1;
+#endif
+    /* O(n^2) */
+    register_algorithm("find_max_seq_sum", O_n_power_2, &find_max_seq_sum_kernel, &setup_array, NULL);
+    register_algorithm("kadane_max_seq_sum", O_n, &kadane_max_seq_sum_kernel, &setup_max_seq, NULL);
+    register_algorithm("simd_max_seq_sum", O_n, &simd_max_seq_sum_kernel, &setup_max_seq, NULL);
+    register_algorithm("parallel_max_seq_sum", O_n, &parallel_max_seq_sum_kernel, &setup_max_seq, NULL)->parallel = 1;
+#ifdef BIGO_OFFLOAD
+    register_algorithm("offload_max_seq_sum", O_n, &offload_max_seq_sum_kernel, &setup_offload_max_seq, &offload_release)->parallel = 1;
+#endif
+    /* O(2^n) */
+    register_algorithm("solve_hanoi", O_2_power_n, &solve_hanoi_kernel, &setup_hanoi, NULL);
+    register_algorithm("gray_code_hanoi", O_2_power_n, &gray_code_hanoi_kernel, &setup_hanoi_moves, NULL);
+    register_algorithm("gray_code_hanoi_count", O_2_power_n, &gray_code_hanoi_kernel, &setup_hanoi, NULL);
+    /* O(n!) */
+    register_algorithm("tsp_brute_force", O_n_permut, &tsp_brute_force_kernel, &setup_tsp_brute_force, NULL)->parallel = 1;
+    register_algorithm("tsp_held_karp", O_2_power_n, &tsp_held_karp_kernel, &setup_tsp, NULL)->parallel = 1;
+    /* O(n^n) */
+    register_algorithm("do_nothing", O_n_power_n, &do_nothing_kernel, &setup_nothing, NULL);
+}
+
+/* [=] Setup the environment for
+ * the registered algorithms
+ */
+struct environment* create_environments_on(long sz, int node) {
+    struct arena *arena = arena_create(node);
+    int i;
+
+    /* every size gets its own
+     * (reproducible) numbers */
+    struct inputs in = { .sz = sz, .seed = rng_create(options.seed, sz).seed };
+
+    /* one more for the end
+     * marker */
+    struct environment *environments = calloc(registry.num + 1, sizeof(struct environment));
+
+    bench_arena = arena;
+    for(i = 0;i < registry.num;i++) {
+        struct algorithm *algorithm = &registry.algorithms[i];
+        struct environment *environment = &environments[i];
+
+        environment->n = sz;
+        environment->name = algorithm->name;
+        environment->algo = algorithm->run;
+        environment->oclass = algorithm->oclass;
+        environment->parallel = algorithm->parallel;
+        environment->release = algorithm->teardown;
+        environment->arena = arena;
+        algorithm->setup(environment, &in);
+    }
+    environments[registry.num].arena = arena;
+    check_inputs(&in);
+    bench_arena = NULL;
+
+    return environments;
+}
+struct environment* create_environments(long sz) {
+    return create_environments_on(sz, -1);
+}
+
+/* [=] Let the algorithms tidy
+ * up then drop everything they
+ * were given in one go
+ */
+void destroy_environments(struct environment *environments) {
+    struct environment *environment;
+
+    for(environment = environments;environment->algo;environment++) {
+        if(environment->release && environment->data) environment->release(environment->data);
+    }
+    /* the end marker has it too */
+    arena_release(environment->arena);
+    free(environments);
+}
+
+/* (concurrent runner) */
+
+/* Independent environments can
+ * run at the same time, each on
+ * its own pinned core, so a
+ * sweep takes about 1/cores the
+ * time. With more than one NUMA
+ * node each gets its own copy of
+ * the environments, allocated on
+ * the node, so no one measures a
+ * remote memory access.
+ *
+ * The parallel ones need all the
+ * cores so run on their own
+ * afterwards - as does
+ * everything with --isolated.
+ */
+struct topology {
+    int num_cpus;
+    int *cpus;
+    int *nodes;
+    int num_nodes;
+};
+static struct topology topology;
+
+/* [=] Is `cpu` in a sysfs cpu
+ * list like "0-3,8,10-11"
+ */
+int in_cpu_list_1(char *list, int cpu) {
+    while(*list) {
+        char *end;
+        long from = strtol(list, &end, 10), to = from;
+        if(end == list) break;
+        if(*end == '-') to = strtol(end + 1, &end, 10);
+        if(cpu >= from && cpu <= to) return 1;
+        list = *end == ',' ? end + 1 : end;
+        if(*list == '\n') break;
+    }
+    return 0;
+}
+/* [=] The cpus we may run on and
+ * the node of each
+ */
+void read_topology() {
+    cpu_set_t set;
+    char lists[64][1024];
+    int have[64] = {0};
+    int cpu, node;
+
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set)) CPU_SET(0, &set);
+    topology.cpus = malloc(sizeof(int)*CPU_SETSIZE);
+    topology.nodes = malloc(sizeof(int)*CPU_SETSIZE);
+    topology.num_nodes = 1;
+
+    for(node = 0;node < 64;node++) {
+        char path[128];
+        FILE *f;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if(!(f = fopen(path, "r"))) continue;
+        have[node] = fgets(lists[node], sizeof(lists[node]), f) != NULL;
+        fclose(f);
+    }
+    for(cpu = 0;cpu < CPU_SETSIZE;cpu++) {
+        if(!CPU_ISSET(cpu, &set)) continue;
+        topology.cpus[topology.num_cpus] = cpu;
+        topology.nodes[topology.num_cpus] = 0;
+        for(node = 0;node < 64;node++) {
+            if(have[node] && in_cpu_list_1(lists[node], cpu)) {
+                topology.nodes[topology.num_cpus] = node;
+                if(node + 1 > topology.num_nodes) topology.num_nodes = node + 1;
+                break;
+            }
+        }
+        topology.num_cpus++;
+    }
+}
+
+/* One copy of the environments
+ * per node (just the one without
+ * NUMA) and where each stands.
+ */
+struct environment_sets {
+    struct environment **sets;
+    int num_sets;
+    int num;
+};
+enum run_state {
+    WAITING,
+    RUNNING,
+    DONE,
+};
+struct runner {
+    struct environment_sets *es;
+    int *todo;
+    struct stats *stats;
+    enum run_state *state;
+    void **held;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+struct runner_job {
+    struct runner *runner;
+    int cpu;
+    int node;
+};
+
+/* [=] The environments for a size
+ * - a copy per NUMA node used by
+ * the concurrent runner
+ */
+struct environment_sets* create_environment_sets(long sz) {
+    struct environment_sets *es = malloc(sizeof(struct environment_sets));
+    int i;
+
+    es->num_sets = options.jobs > 1 && topology.num_nodes > 1 ? topology.num_nodes : 1;
+    es->sets = malloc(sizeof(struct environment*)*es->num_sets);
+    for(i = 0;i < es->num_sets;i++) {
+        es->sets[i] = create_environments_on(sz, es->num_sets > 1 ? i : -1);
+    }
+    for(es->num = 0;es->sets[0][es->num].algo;es->num++);
+    return es;
+}
+void destroy_environment_sets(struct environment_sets *es) {
+    int i;
+    for(i = 0;i < es->num_sets;i++) destroy_environments(es->sets[i]);
+    free(es->sets);
+    free(es);
+}
+
+/* [=] Can environment `i` start -
+ * nothing running holds its key
+ */
+int runner_free_1(struct runner *r, struct environment *environment) {
+    int k;
+    if(!environment->exclusive) return 1;
+    for(k = 0;k < r->es->num;k++) {
+        if(r->held[k] == environment->exclusive) return 0;
+    }
+    return 1;
+}
+void* runner_1(void *data) {
+    struct runner_job *job = data;
+    struct runner *r = job->runner;
+    struct environment *set = job->runner->es->sets[job->runner->es->num_sets > 1 ? job->node : 0];
+
+    pin_to_cpu(job->cpu);
+    bench_runner = 1;
+    pthread_mutex_lock(&r->lock);
+    for(;;) {
+        int i, waiting = 0, next = -1;
+
+        for(i = 0;i < r->es->num;i++) {
+            if(!r->todo[i] || r->state[i] != WAITING) continue;
+            waiting++;
+            if(runner_free_1(r, &set[i])) {
+                next = i;
+                break;
+            }
+        }
+        if(!waiting) break;
+        if(next < 0) {
+            pthread_cond_wait(&r->cond, &r->lock);
+            continue;
+        }
+        r->state[next] = RUNNING;
+        r->held[next] = set[next].exclusive;
+        pthread_mutex_unlock(&r->lock);
+
+        r->stats[next] = bench_environment(&set[next]);
+
+        pthread_mutex_lock(&r->lock);
+        r->state[next] = DONE;
+        r->held[next] = NULL;
+        pthread_cond_broadcast(&r->cond);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+/* [=] Benchmark the environments
+ * with `todo` set and no other
+ * threads of their own, one per
+ * core. Their stats go in
+ * `stats`; the others are left
+ * for the caller to run alone.
+ */
+void run_concurrently(struct environment_sets *es, int *todo, struct stats *stats) {
+    struct runner r;
+    int num_jobs = options.jobs < topology.num_cpus ? options.jobs : topology.num_cpus;
+    pthread_t threads[num_jobs > 0 ? num_jobs : 1];
+    struct runner_job jobs[num_jobs > 0 ? num_jobs : 1];
+    int i;
+
+    r.es = es;
+    r.todo = calloc(es->num, sizeof(int));
+    r.stats = stats;
+    r.state = calloc(es->num, sizeof(enum run_state));
+    r.held = calloc(es->num, sizeof(void*));
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.cond, NULL);
+    for(i = 0;i < es->num;i++) {
+        r.todo[i] = todo[i] && es->sets[0][i].data && !es->sets[0][i].parallel;
+        todo[i] = r.todo[i];
+    }
+
+    for(i = 0;i < num_jobs;i++) {
+        jobs[i].runner = &r;
+        jobs[i].cpu = topology.cpus[i];
+        jobs[i].node = topology.nodes[i];
+        pthread_create(&threads[i], NULL, runner_1, &jobs[i]);
+    }
+    for(i = 0;i < num_jobs;i++) pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&r.lock);
+    pthread_cond_destroy(&r.cond);
+    free(r.todo);
+    free(r.state);
+    free(r.held);
+}
+
+/* [=] Show results of running
+ * all algos in their
+ * environments.
+ */
+void show_algo_results(long sz) {
+    struct environment_sets *es = create_environment_sets(sz);
+    struct stats *stats = calloc(es->num, sizeof(struct stats));
+    int *ran = malloc(sizeof(int)*es->num);
+    int i;
+
+    for(i = 0;i < es->num;i++) ran[i] = options.jobs > 1;
+    if(options.jobs > 1) run_concurrently(es, ran, stats);
+    for(i = 0;i < es->num;i++) {
+        if(ran[i]) show_stats(&es->sets[0][i], &stats[i]);
+        else show_time_taken(&es->sets[0][i]);
+    }
+
+    free(stats);
+    free(ran);
+    destroy_environment_sets(es);
+}
+
+/* [=] log(f(n)) for the curve
+ * of each Big(O) class. We
+ * work in logs because 2^n, n!
+ * and n^n overflow a double
+ * long before n gets
+ * interesting.
+ */
+double oclass_log_curve(enum OClass oclass, double n) {
+    double lg = log2(n < 2 ? 2 : n);
+    switch(oclass) {
+        case O1: return 0;
+        case O_logn: return log(lg);
+        case O_sqrtn: return 0.5 * log(n);
+        case O_n: return log(n);
+        case O_nlogn: return log(n) + log(lg);
+        case O_n_power_2: return 2 * log(n);
+        case O_2_power_n: return n * log(2);
+        case O_n_permut: return lgamma(n + 1);
+        case O_n_power_n: return n * log(n);
+        default: return 0;
+    }
+}
+
+/* The fit of measured times
+ * against one Big(O) class:
+ *  time ~= constant * f(n)
+ */
+struct fit {
+    enum OClass oclass;
+    double constant;
+    double error;
+};
+
+/* [=] Least squares fit of
+ * log(time) = log(c) + log(f(n))
+ * for one class. The error is
+ * the mean squared residual (in
+ * log space) so it compares
+ * fairly across classes.
+ */
+struct fit fit_oclass_1(enum OClass oclass, long *sizes, double *times, int num) {
+    struct fit fit;
+    double mean = 0, error = 0;
+    int i;
+
+    for(i = 0;i < num;i++) {
+        mean += log(times[i]) - oclass_log_curve(oclass, sizes[i]);
+    }
+    mean /= num;
+    for(i = 0;i < num;i++) {
+        double r = log(times[i]) - oclass_log_curve(oclass, sizes[i]) - mean;
+        error += r * r;
+    }
+
+    fit.oclass = oclass;
+    fit.constant = exp(mean);
+    fit.error = error / num;
+    return fit;
+}
+
+/* [=] Find the class whose
+ * curve best matches the
+ * measured times.
+ */
+struct fit fit_oclass(long *sizes, double *times, int num) {
+    struct fit best = fit_oclass_1(O1, sizes, times, num);
+    int oclass;
+
+    for(oclass = O1 + 1;oclass <= O_n_power_n;oclass++) {
+        struct fit fit = fit_oclass_1(oclass, sizes, times, num);
+        if(fit.error < best.error) best = fit;
+    }
+    return best;
+}
+
+/* The sizes to sweep and the
+ * times measured for each
+ * environment at each size.
+ */
+struct sweep {
+    long *sizes;
+    int num_sizes;
+};
+
+/* [=] Parse a sweep spec:
+ *  <from>:<to>:x<factor>
+ *  <from>:<to>:+<step>
+ * eg: 1e3:1e7:x2
+ */
+struct sweep* parse_sweep(char *spec) {
+    double from, to, step;
+    char op;
+    long sz;
+    struct sweep *sweep;
+
+    if(sscanf(spec, "%lf:%lf:%c%lf", &from, &to, &op, &step) != 4) return NULL;
+    if(from < 1 || to < from) return NULL;
+    if(op != 'x' && op != '+') return NULL;
+    if(op == 'x' && step <= 1) return NULL;
+    if(op == '+' && step < 1) return NULL;
+
+    sweep = malloc(sizeof(struct sweep));
+    sweep->num_sizes = 0;
+    sweep->sizes = malloc(sizeof(long));
+    for(sz = (long)from;sz <= (long)to;) {
+        sweep->sizes = realloc(sweep->sizes, sizeof(long)*(sweep->num_sizes+1));
+        sweep->sizes[sweep->num_sizes++] = sz;
+        if(op == 'x') sz = (long)(sz * step) > sz ? (long)(sz * step) : sz + 1;
+        else sz += (long)step;
+    }
+    return sweep;
+}
+
+/* [=] Estimate the seconds one
+ * run will take at size `i` from
+ * the fit of the smaller sizes
+ * (or -1 if they are too few)
+ */
+double estimate_seconds(struct sweep *sweep, double *times, int i) {
+    long sizes[i > 0 ? i : 1];
+    double ts[i > 0 ? i : 1];
+    struct fit fit;
+    int k, num = 0;
+
+    for(k = 0;k < i;k++) {
+        if(times[k] <= 0) continue;
+        sizes[num] = sweep->sizes[k];
+        ts[num] = times[k];
+        num++;
+    }
+    if(num < 2) return -1;
+    fit = fit_oclass(sizes, ts, num);
+    return fit.constant * exp(oclass_log_curve(fit.oclass, sweep->sizes[i]));
+}
+
+/* (cache sweep) */
+
+/* `--sweep cache` puts sizes
+ * either side of each cache so
+ * the knees show: per probe or
+ * element the cost jumps as the
+ * data spills out of L1, L2, L3
+ * and into DRAM - whatever the
+ * Big(O) class says.
+ */
+#define MAX_CACHE_LEVELS 8
+struct cache_level {
+    int level;
+    long bytes;
+};
+static struct cache_level cache_levels[MAX_CACHE_LEVELS];
+static int num_cache_levels;
+
+void add_cache_level_1(int level, long bytes) {
+    int i;
+    if(bytes <= 0 || num_cache_levels == MAX_CACHE_LEVELS) return;
+    for(i = 0;i < num_cache_levels;i++) if(cache_levels[i].level == level) return;
+    cache_levels[num_cache_levels].level = level;
+    cache_levels[num_cache_levels].bytes = bytes;
+    num_cache_levels++;
+}
+/* [=] Data and unified caches
+ * of cpu0 from sysfs
+ */
+void read_caches_sysfs_1() {
+    int i;
+
+    for(i = 0;i < 16;i++) {
+        char path[128], type[32], size[32];
+        int level = 0;
+        long bytes;
+        char unit = 0;
+        FILE *f;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        if(!(f = fopen(path, "r"))) break;
+        if(!fgets(type, sizeof(type), f)) type[0] = 0;
+        fclose(f);
+        if(!strncmp(type, "Instruction", 11)) continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        if(!(f = fopen(path, "r"))) continue;
+        if(fscanf(f, "%d", &level) != 1) level = 0;
+        fclose(f);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if(!(f = fopen(path, "r"))) continue;
+        if(!fgets(size, sizeof(size), f)) size[0] = 0;
+        fclose(f);
+        if(sscanf(size, "%ld%c", &bytes, &unit) < 1) continue;
+        if(unit == 'K') bytes <<= 10;
+        else if(unit == 'M') bytes <<= 20;
+        else if(unit == 'G') bytes <<= 30;
+        add_cache_level_1(level, bytes);
+    }
+}
+/* [=] Otherwise ask the cpu
+ * (cpuid leaf 4)
+ */
+void read_caches_cpuid_1() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx, i;
+
+    if(__get_cpuid_max(0, NULL) < 4) return;
+    for(i = 0;i < 16;i++) {
+        int type;
+        long ways, partitions, line, sets;
+
+        __cpuid_count(4, i, eax, ebx, ecx, edx);
+        type = eax & 0x1f;
+        if(!type) break;
+        /* 2 is the instruction cache */
+        if(type == 2) continue;
+        ways = ((ebx >> 22) & 0x3ff) + 1;
+        partitions = ((ebx >> 12) & 0x3ff) + 1;
+        line = (ebx & 0xfff) + 1;
+        sets = (long)ecx + 1;
+        add_cache_level_1((eax >> 5) & 7, ways * partitions * line * sets);
+    }
+#endif
+}
+int cmp_cache_level_1(const void *a, const void *b) {
+    return ((struct cache_level*)a)->level - ((struct cache_level*)b)->level;
+}
+/* [=] Returns how many cache
+ * levels we found
+ */
+int read_caches() {
+    if(!num_cache_levels) read_caches_sysfs_1();
+    if(!num_cache_levels) read_caches_cpuid_1();
+    qsort(cache_levels, num_cache_levels, sizeof(struct cache_level), cmp_cache_level_1);
+    return num_cache_levels;
+}
+/* [=] Where `bytes` live: the
+ * first cache they fit in, or
+ * DRAM (num_cache_levels)
+ */
+int cache_level_of(long bytes) {
+    int i;
+    for(i = 0;i < num_cache_levels;i++) {
+        if(bytes <= cache_levels[i].bytes) break;
+    }
+    return i;
+}
+char* cache_level_1_str(int i) {
+    static char names[MAX_CACHE_LEVELS][8];
+    if(i >= num_cache_levels) return "DRAM";
+    snprintf(names[i], sizeof(names[i]), "L%d", cache_levels[i].level);
+    return names[i];
+}
+
+/* The sizes used either side of
+ * each cache, as fractions of
+ * it.
+ */
+static double cache_sweep_points[] = { 0.25, 0.5, 0.9, 1.1, 2 };
+
+int cmp_long_1(const void *a, const void *b) {
+    long x = *(long*)a, y = *(long*)b;
+    return x < y ? -1 : x > y;
+}
+/* [=] The sweep for the caches
+ * found - NULL if we found none
+ */
+struct sweep* cache_sweep() {
+    int num_points = sizeof(cache_sweep_points)/sizeof(cache_sweep_points[0]);
+    struct sweep *sweep;
+    int i, k, num = 0;
+
+    if(!read_caches()) return NULL;
+    sweep = malloc(sizeof(struct sweep));
+    sweep->sizes = malloc(sizeof(long)*(num_cache_levels*num_points + 1));
+    for(i = 0;i < num_cache_levels;i++) {
+        for(k = 0;k < num_points;k++) {
+            long sz = (long)(cache_levels[i].bytes * cache_sweep_points[k] / sizeof(int));
+            if(sz >= 16) sweep->sizes[num++] = sz;
+        }
+    }
+    /* well out into DRAM */
+    sweep->sizes[num++] = cache_levels[num_cache_levels-1].bytes * 4 / sizeof(int);
+    qsort(sweep->sizes, num, sizeof(long), cmp_long_1);
+
+    sweep->num_sizes = 0;
+    for(i = 0;i < num;i++) {
+        if(sweep->num_sizes && sweep->sizes[sweep->num_sizes-1] == sweep->sizes[i]) continue;
+        sweep->sizes[sweep->num_sizes++] = sweep->sizes[i];
+    }
+    return sweep;
+}
+
+/* [=] Mean cost per probe or
+ * element in each cache level -
+ * the knees in one line per
+ * environment. Rows that probe
+ * one needle per call are left
+ * out (they only ever see L1).
+ */
+void show_cache_knees(struct sweep *sweep, char **names, double *per_unit, char **units, long *bytes, int *same_probe, int num_envs) {
+    int i, j, level, num_left_out = 0;
+
+    printf("--- ns per probe/element by where the input lives ---\n");
+    printf("%-24s%-7s", "", "");
+    for(level = 0;level <= num_cache_levels;level++) printf("%10s", cache_level_1_str(level));
+    printf("\n");
+    for(j = 0;j < num_envs;j++) {
+        if(same_probe[j]) {
+            num_left_out++;
+            continue;
+        }
+        printf("%-24s%-7s", names[j], units[j] ? units[j] : "");
+        for(level = 0;level <= num_cache_levels;level++) {
+            double sum = 0;
+            int num = 0;
+            for(i = 0;i < sweep->num_sizes;i++) {
+                double t = per_unit[j*sweep->num_sizes + i];
+                if(t <= 0 || cache_level_of(bytes[j*sweep->num_sizes + i]) != level) continue;
+                sum += t;
+                num++;
+            }
+            if(num) printf("%10.4g", sum / num);
+            else printf("%10s", "-");
+        }
+        printf("\n");
+    }
+    if(num_left_out) {
+        printf("(%d row%s that probe the same needle every call left out - see the batch_* rows)\n",
+                num_left_out, num_left_out == 1 ? "" : "s");
+    }
+}
+
+/* [=] Run every environment at
+ * every size in the sweep and
+ * report which Big(O) class the
+ * timings actually match.
+ */
+void show_sweep_results(struct sweep *sweep) {
+    int num_envs = 0;
+    char **names = NULL;
+    enum OClass *oclasses = NULL;
+    double *times = NULL;
+    double *per_unit = NULL;
+    char **units = NULL;
+    long *bytes = NULL;
+    int *same_probe = NULL;
+    int *over_budget = NULL;
+    long *sizes = malloc(sizeof(long)*sweep->num_sizes);
+    double *ts = malloc(sizeof(double)*sweep->num_sizes);
+    int i, j;
+
+    for(i = 0;i < sweep->num_sizes;i++) {
+        struct environment_sets *es = create_environment_sets(sweep->sizes[i]);
+        struct environment *environments = es->sets[0];
+        struct stats *run_stats;
+        double *estimates;
+        int *ran;
+
+        if(options.format == TEXT_FORMAT && options.per_unit) {
+            printf("--- %ld items (", sweep->sizes[i]);
+            show_bytes_msg_1(sweep->sizes[i] * (double)sizeof(int));
+            printf(" in %s) ---\n", cache_level_1_str(cache_level_of(sweep->sizes[i] * (long)sizeof(int))));
+        } else if(options.format == TEXT_FORMAT) {
+            printf("--- %ld items ---\n", sweep->sizes[i]);
+        }
+        if(!names) {
+            num_envs = es->num;
+            names = malloc(sizeof(char*)*num_envs);
+            oclasses = malloc(sizeof(enum OClass)*num_envs);
+            times = malloc(sizeof(double)*num_envs*sweep->num_sizes);
+            per_unit = malloc(sizeof(double)*num_envs*sweep->num_sizes);
+            units = calloc(num_envs, sizeof(char*));
+            bytes = malloc(sizeof(long)*num_envs*sweep->num_sizes);
+            same_probe = malloc(sizeof(int)*num_envs);
+            over_budget = calloc(num_envs, sizeof(int));
+            for(j = 0;j < num_envs;j++) {
+                names[j] = environments[j].name;
+                oclasses[j] = environments[j].oclass;
+                same_probe[j] = same_probe_1(&environments[j]);
+            }
+        }
+
+        /* decide what runs first so
+         * it can all run at once */
+        run_stats = calloc(num_envs, sizeof(struct stats));
+        estimates = malloc(sizeof(double)*num_envs);
+        ran = malloc(sizeof(int)*num_envs);
+        for(j = 0;j < num_envs;j++) {
+            estimates[j] = estimate_seconds(sweep, times + j*sweep->num_sizes, i);
+            ran[j] = options.jobs > 1;
+            /* once over budget the larger
+             * sizes would be too */
+            if(over_budget[j] || (options.budget > 0 && estimates[j] > options.budget)) ran[j] = 0;
+        }
+        if(options.jobs > 1) run_concurrently(es, ran, run_stats);
+
+        for(j = 0;j < num_envs;j++) {
+            struct stats stats;
+
+            bytes[j*sweep->num_sizes + i] = row_bytes_1(&environments[j]);
+            if(over_budget[j] && environments[j].data) {
+                show_skipped(&environments[j], 0);
+                times[j*sweep->num_sizes + i] = -1;
+                per_unit[j*sweep->num_sizes + i] = -1;
+                continue;
+            }
+            if(options.budget > 0 && estimates[j] > options.budget && environments[j].data) {
+                show_skipped(&environments[j], estimates[j]);
+                times[j*sweep->num_sizes + i] = -1;
+                per_unit[j*sweep->num_sizes + i] = -1;
+                over_budget[j] = 1;
+                continue;
+            }
+
+            if(ran[j]) {
+                stats = run_stats[j];
+                show_stats(&environments[j], &stats);
+            } else {
+                stats = show_time_taken(&environments[j]);
+            }
+            times[j*sweep->num_sizes + i] = stats.samples ? stats.median * 1e-9 : -1;
+            per_unit[j*sweep->num_sizes + i] = stats.samples ? stats.median / per_unit_1(&environments[j], &units[j]) : -1;
+            over_budget[j] = stats.over_budget;
+        }
+        free(run_stats);
+        free(estimates);
+        free(ran);
+        destroy_environment_sets(es);
+    }
+
+    /* the fit is for people - the
+     * records have the numbers */
+    if(options.format == TEXT_FORMAT) printf("--- fit ---\n");
+    for(j = 0;options.format == TEXT_FORMAT && j < num_envs;j++) {
+        int num = 0;
+        struct fit fit;
+
+        for(i = 0;i < sweep->num_sizes;i++) {
+            double t = times[j*sweep->num_sizes + i];
+            /* skip rows that did not
+             * run */
+            if(t <= 0) continue;
+            sizes[num] = sweep->sizes[i];
+            ts[num] = t;
+            num++;
+        }
+        printf("%-24s expected %-12s", names[j], oclass_1_str(oclasses[j]));
+        if(num < 2) {
+            printf("(not enough measurements)\n");
+            continue;
+        }
+        fit = fit_oclass(sizes, ts, num);
+        printf("measured %-12s c = %.3e s (error %.3f)%s\n",
+                oclass_1_str(fit.oclass),
+                fit.constant,
+                fit.error,
+                fit.oclass == oclasses[j] ? "" : " <- MISMATCH");
+    }
+    if(options.format == TEXT_FORMAT && options.per_unit) show_cache_knees(sweep, names, per_unit, units, bytes, same_probe, num_envs);
+
+    free(sizes);
+    free(ts);
+    free(names);
+    free(oclasses);
+    free(times);
+    free(per_unit);
+    free(units);
+    free(bytes);
+    free(same_probe);
+    free(over_budget);
+}
+
+/* (verify engines) */
+
+/* Engines that work out the
+ * same thing as a reference
+ * engine, which is the simplest
+ * (or best trusted) one.
+ */
+struct verify_group {
+    char *reference;
+    char *engines;
+    /* also checked with a needle
+     * that is not there */
+    int absent;
+};
+static struct verify_group verify_groups[] = {
+    { "linear_search", "^(binary_jump|branchless|eytzinger)_search|^linear_search_|^packed_|^offload_linear_search$", 1 },
+    { "find_first_scalar", "^simd_search", 1 },
+    { "batch_binary_loop", "^batch_binary_search$|^batch_linear_", 0 },
+    { "sqrt_range_stream", "^(fenwick|sparse)_range_stream$", 0 },
+    { "range_sum_loop", "^range_batch_sums$", 0 },
+    { "slice_sums_build", "^offload_slice_sums$", 0 },
+    { "intro_sort", "^(quick_sort|parallel_quick_sort|radix_sort|offload_radix_sort)$", 0 },
+    { "kadane_max_seq_sum", "^(find_max_seq_sum|simd_max_seq_sum|parallel_max_seq_sum|offload_max_seq_sum)$", 0 },
+    { "solve_hanoi", "^gray_code_hanoi_count$", 0 },
+    { "tsp_brute_force", "^tsp_held_karp$", 0 },
+    { NULL, NULL, 0 },
+};
+
+/* [=] Run once (within the time
+ * budget) and say what it came
+ * to. Returns 0 if it ran out
+ * of time.
+ */
+int verify_run_1(struct environment *environment, double *result) {
+    struct watchdog watchdog;
+    int ok;
+
+    if(options.budget > 0) watchdog_start(&watchdog, options.budget);
+    if(environment->setup) environment->setup(environment->fixture);
+    bench_result = NAN;
+    environment->algo(environment->data, 1);
+    *result = environment->digest ? environment->digest(environment) : bench_result;
+    if(environment->teardown) environment->teardown(environment->fixture);
+    ok = !CANCELLED();
+    if(options.budget > 0) watchdog_stop(&watchdog);
+    return ok;
+}
+int same_result_1(double a, double b) {
+    return a == b || fabs(a - b) <= 1e-9 * fmax(fabs(a), fabs(b));
+}
+
+/* [=] Check every engine that
+ * ran at this size against its
+ * reference (only the searches
+ * when the needle is absent).
+ * Returns how many disagree.
+ */
+int verify_environments(struct environment *environments) {
+    struct verify_group *group;
+    int failed = 0;
+
+    for(group = verify_groups;group->reference;group++) {
+        struct environment *reference = NULL, *environment;
+        double expected = 0;
+        int have_reference = 0;
+        regex_t re;
+
+        if(absent_needle && !group->absent) continue;
+        if(regcomp(&re, group->engines, REG_EXTENDED|REG_NOSUB)) continue;
+        for(environment = environments;environment->algo;environment++) {
+            if(!strcmp(environment->name, group->reference)) reference = environment;
+        }
+        for(environment = environments;environment->algo;environment++) {
+            double got;
+
+            if(regexec(&re, environment->name, 0, NULL, 0) || !environment->data) continue;
+            printf("%-24s (%ld items%s): ", environment->name, environment->n, absent_needle ? ", absent needle" : "");
+            if(!reference || !reference->data) {
+                printf("not checked - %s did not run\n", group->reference);
+                continue;
+            }
+            if(!have_reference) {
+                if(!verify_run_1(reference, &expected)) {
+                    printf("not checked - %s over budget\n", group->reference);
+                    reference = NULL;
+                    continue;
+                }
+                have_reference = 1;
+            }
+            if(!verify_run_1(environment, &got)) {
+                printf("not checked - over budget\n");
+            } else if(same_result_1(got, expected)) {
+                printf("ok (agrees with %s)\n", group->reference);
+            } else {
+                printf("FAILED: %.17g but %s says %.17g\n", got, group->reference, expected);
+                failed++;
+            }
+        }
+        regfree(&re);
+    }
+    return failed;
+}
+
+/* [=] --verify at each size of
+ * the sweep, then the searches
+ * again for a needle that is
+ * not there
+ */
+int verify_sweep(struct sweep *sweep) {
+    int i, failed = 0;
+
+    for(absent_needle = 0;absent_needle < 2;absent_needle++) {
+        for(i = 0;i < sweep->num_sizes;i++) {
+            struct environment *environments = create_environments(sweep->sizes[i]);
+            failed += verify_environments(environments);
+            destroy_environments(environments);
+        }
+    }
+    absent_needle = 0;
+    if(failed) printf("%d engine(s) disagree with their reference\n", failed);
+    return failed;
+}
+
+/* (out of core streams) */
+
+/* For inputs bigger than
+ * memory. The items live in a
+ * file and are read a chunk at a
+ * time into one buffer while the
+ * algorithm works through the
+ * other. The reads go through
+ * io_uring when the kernel lets
+ * us, else through a reader
+ * thread. The file is opened
+ * O_DIRECT (where the filesystem
+ * allows) so the page cache
+ * doesn't hide the disk.
+ */
+#define STREAM_CHUNK (1L << 22)
+/* O_DIRECT wants offsets, sizes
+ * and buffers aligned to this */
+#define STREAM_ALIGN 4096
+
+/* [=] The items are just signed
+ * random numbers - so the max
+ * sequential sum is not the
+ * total */
+int stream_value_1(long i) {
+    return (int)(random_at(options.seed, i) >> 32);
+}
+
+/* [=] pread until `len` bytes
+ * or the end of the file.
+ * Returns the bytes read or -1.
+ */
+ssize_t read_fully_1(int fd, void *buf, size_t len, off_t off) {
+    size_t got = 0;
+
+    while(got < len) {
+        ssize_t r = pread(fd, (char*)buf + got, len - got, off + got);
+        if(r < 0 && errno == EINTR) continue;
+        if(r < 0) return -1;
+        if(r == 0) break;
+        got += r;
+    }
+    return got;
+}
+int write_fully_1(int fd, void *buf, size_t len, off_t off) {
+    size_t put = 0;
+
+    while(put < len) {
+        ssize_t r = pwrite(fd, (char*)buf + put, len - put, off + put);
+        if(r < 0 && errno == EINTR) continue;
+        if(r <= 0) return 0;
+        put += r;
+    }
+    return 1;
+}
+
+#ifdef BIGO_IO_URING
+/* Just enough io_uring (one read
+ * in flight) to go without
+ * liburing.
+ */
+struct uring {
+    int fd;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_sz;
+    size_t cq_sz;
+    size_t sqes_sz;
+};
+int uring_open_1(struct uring *u) {
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof(p));
+    u->fd = syscall(__NR_io_uring_setup, 2, &p);
+    if(u->fd < 0) return 0;
+
+    u->sq_sz = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    u->cq_sz = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP) {
+        if(u->cq_sz > u->sq_sz) u->sq_sz = u->cq_sz;
+        u->cq_sz = 0;
+    }
+    u->sqes_sz = p.sq_entries*sizeof(struct io_uring_sqe);
+    u->sq_ring = mmap(NULL, u->sq_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    u->cq_ring = u->cq_sz ? mmap(NULL, u->cq_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_CQ_RING) : u->sq_ring;
+    u->sqes = mmap(NULL, u->sqes_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if(u->sq_ring == MAP_FAILED || u->cq_ring == MAP_FAILED || u->sqes == MAP_FAILED) {
+        close(u->fd);
+        u->fd = -1;
+        return 0;
+    }
+    u->sq_tail = (unsigned*)((char*)u->sq_ring + p.sq_off.tail);
+    u->sq_mask = (unsigned*)((char*)u->sq_ring + p.sq_off.ring_mask);
+    u->sq_array = (unsigned*)((char*)u->sq_ring + p.sq_off.array);
+    u->cq_head = (unsigned*)((char*)u->cq_ring + p.cq_off.head);
+    u->cq_tail = (unsigned*)((char*)u->cq_ring + p.cq_off.tail);
+    u->cq_mask = (unsigned*)((char*)u->cq_ring + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe*)((char*)u->cq_ring + p.cq_off.cqes);
+    return 1;
+}
+void uring_close_1(struct uring *u) {
+    if(u->fd < 0) return;
+    munmap(u->sqes, u->sqes_sz);
+    if(u->cq_sz) munmap(u->cq_ring, u->cq_sz);
+    munmap(u->sq_ring, u->sq_sz);
+    close(u->fd);
+    u->fd = -1;
+}
+int uring_read_1(struct uring *u, int fd, void *buf, size_t len, off_t off) {
+    unsigned tail = *u->sq_tail;
+    unsigned idx = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = off;
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return syscall(__NR_io_uring_enter, u->fd, 1, 0, 0, NULL, 0) == 1;
+}
+/* [=] Wait for the read: the
+ * bytes read or -errno */
+long uring_wait_1(struct uring *u) {
+    for(;;) {
+        unsigned head = *u->cq_head;
+        if(head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+            long res = u->cqes[head & *u->cq_mask].res;
+            __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+            return res;
+        }
+        if(syscall(__NR_io_uring_enter, u->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) return -errno;
+    }
+}
+#endif
+
+/* The fallback: a thread that
+ * makes one read at a time.
+ */
+struct stream_reader {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int fd;
+    void *buf;
+    size_t len;
+    off_t off;
+    ssize_t got;
+    int busy;
+    int quit;
+};
+void* stream_reader_1(void *arg) {
+    struct stream_reader *r = arg;
+
+    pthread_mutex_lock(&r->lock);
+    for(;;) {
+        ssize_t got;
+        while(!r->busy && !r->quit) pthread_cond_wait(&r->cond, &r->lock);
+        if(r->quit) break;
+        pthread_mutex_unlock(&r->lock);
+        got = read_fully_1(r->fd, r->buf, r->len, r->off);
+        pthread_mutex_lock(&r->lock);
+        r->got = got;
+        r->busy = 0;
+        pthread_cond_broadcast(&r->cond);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+struct stream {
+    char path[4096];
+    int keep;
+    int fd;
+    int direct;
+    long sz;
+    long chunk;
+    /* the read in flight goes to
+     * bufs[cur] */
+    int *bufs[2];
+    int cur;
+    long next;
+    long in_flight;
+    /* what the last run read and
+     * how long it sat waiting */
+    long items;
+    long long wait_ns;
+#ifdef BIGO_IO_URING
+    struct uring uring;
+#endif
+    int using_uring;
+    struct stream_reader *reader;
+};
+
+void stream_reader_start_1(struct stream *s) {
+    struct stream_reader *r = calloc(1, sizeof(struct stream_reader));
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    pthread_create(&r->thread, NULL, stream_reader_1, r);
+    s->reader = r;
+}
+void stream_submit_1(struct stream *s, void *buf, long first, long count) {
+    size_t len = count*sizeof(int);
+    off_t off = first*sizeof(int);
+
+    /* past the end just comes
+     * back short */
+    if(s->direct) len = (len + STREAM_ALIGN - 1) & ~(size_t)(STREAM_ALIGN - 1);
+#ifdef BIGO_IO_URING
+    if(s->using_uring) {
+        if(uring_read_1(&s->uring, s->fd, buf, len, off)) return;
+        uring_close_1(&s->uring);
+        s->using_uring = 0;
+        stream_reader_start_1(s);
+    }
+#endif
+    pthread_mutex_lock(&s->reader->lock);
+    s->reader->fd = s->fd;
+    s->reader->buf = buf;
+    s->reader->len = len;
+    s->reader->off = off;
+    s->reader->busy = 1;
+    pthread_cond_broadcast(&s->reader->cond);
+    pthread_mutex_unlock(&s->reader->lock);
+}
+/* [=] Wait for the read in
+ * flight (redoing it here if it
+ * failed - eg: a filesystem that
+ * opens O_DIRECT but won't read
+ * it). Returns the items read.
+ */
+long stream_wait_1(struct stream *s) {
+    long long begin = now_ns();
+    long first = s->next, count = s->in_flight;
+    ssize_t got;
+
+#ifdef BIGO_IO_URING
+    if(s->using_uring) got = uring_wait_1(&s->uring);
+    else
+#endif
+    {
+        pthread_mutex_lock(&s->reader->lock);
+        while(s->reader->busy) pthread_cond_wait(&s->reader->cond, &s->reader->lock);
+        got = s->reader->got;
+        pthread_mutex_unlock(&s->reader->lock);
+    }
+    if(got >= 0 && got < count*(long)sizeof(int) && got % STREAM_ALIGN == 0) {
+        /* a short read that isn't
+         * the end - get the rest */
+        ssize_t more = read_fully_1(s->fd, (char*)s->bufs[s->cur] + got, count*sizeof(int) - got, first*sizeof(int) + got);
+        got = more < 0 ? more : got + more;
+    }
+    if(got < 0 && s->direct) {
+        fcntl(s->fd, F_SETFL, fcntl(s->fd, F_GETFL) & ~O_DIRECT);
+        s->direct = 0;
+        got = read_fully_1(s->fd, s->bufs[s->cur], count*sizeof(int), first*sizeof(int));
+    }
+    s->wait_ns += now_ns() - begin;
+    s->in_flight = 0;
+    return got < 0 ? 0 : ((long)(got / sizeof(int)) < count ? (long)(got / sizeof(int)) : count);
+}
+
+/* [=] Start again from the
+ * first item */
+void stream_rewind(struct stream *s) {
+    if(s->in_flight) stream_wait_1(s);
+    s->cur = 0;
+    s->next = 0;
+    s->items = 0;
+    s->wait_ns = 0;
+    s->in_flight = s->chunk < s->sz ? s->chunk : s->sz;
+    if(s->in_flight) stream_submit_1(s, s->bufs[0], 0, s->in_flight);
+}
+/* [=] The next chunk - starting
+ * the read of the one after it
+ * first. The chunk stays good
+ * until the next call. Returns
+ * 0 at the end.
+ */
+long stream_next(struct stream *s, int **vals) {
+    long count = s->in_flight, got;
+
+    if(!count) return 0;
+    got = stream_wait_1(s);
+    if(got < count) {
+        fprintf(stderr, "stream read failed at item %ld: %s\n", s->next + got, strerror(errno));
+        return 0;
+    }
+    *vals = s->bufs[s->cur];
+    s->cur ^= 1;
+    s->next += count;
+    s->items += count;
+    s->in_flight = s->sz - s->next < s->chunk ? s->sz - s->next : s->chunk;
+    if(s->in_flight) stream_submit_1(s, s->bufs[s->cur], s->next, s->in_flight);
+    return count;
+}
+
+/* [=] Where the stream files go:
+ * the --cache directory (where
+ * they are kept) or TMPDIR */
+char* stream_dir_1() {
+    char *dir = getenv("TMPDIR");
+    if(options.cache) return options.cache;
+    return dir && *dir ? dir : "/tmp";
+}
+/* [=] A file that goes away
+ * when closed */
+int stream_temp_1() {
+    char path[4096];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/bigo-sort-XXXXXX", stream_dir_1());
+    fd = mkstemp(path);
+    if(fd >= 0) unlink(path);
+    else fprintf(stderr, "cannot make a temporary file in %s: %s\n", stream_dir_1(), strerror(errno));
+    return fd;
+}
+/* [=] Write the items a chunk at
+ * a time (never all in memory),
+ * then push them out of the page
+ * cache */
+int stream_generate_1(char *path, long sz, int *buf, long chunk) {
+    char tmp[4096 + 8];
+    long first, i;
+    int fd;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fd < 0) return 0;
+    for(first = 0;first < sz;first += chunk) {
+        long count = sz - first < chunk ? sz - first : chunk;
+        for(i = 0;i < count;i++) buf[i] = stream_value_1(first + i);
+        if(!write_fully_1(fd, buf, count*sizeof(int), first*sizeof(int))) {
+            close(fd);
+            unlink(tmp);
+            return 0;
+        }
+    }
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return rename(tmp, path) == 0;
+}
+
+/* [=] Open (making if needed) the
+ * stream of `sz` items. Returns
+ * NULL if it can't.
+ */
+struct stream* stream_open(long sz) {
+    struct stream *s = calloc(1, sizeof(struct stream));
+    struct stat st;
+    int i;
+
+    s->sz = sz;
+    s->chunk = options.chunk ? options.chunk : STREAM_CHUNK;
+    /* whole aligned blocks */
+    s->chunk = (s->chunk + STREAM_ALIGN/sizeof(int) - 1) & ~(long)(STREAM_ALIGN/sizeof(int) - 1);
+    for(i = 0;i < 2;i++) s->bufs[i] = aligned_alloc(STREAM_ALIGN, s->chunk*sizeof(int));
+    s->keep = options.cache != NULL;
+    snprintf(s->path, sizeof(s->path), "%s/bigo-stream-%ld-%llu.dat", stream_dir_1(), sz, (unsigned long long)options.seed);
+
+    if(stat(s->path, &st) || st.st_size != (off_t)(sz*sizeof(int))) {
+        if(!stream_generate_1(s->path, sz, s->bufs[0], s->chunk)) {
+            fprintf(stderr, "cannot write %s: %s\n", s->path, strerror(errno));
+            free(s->bufs[0]);
+            free(s->bufs[1]);
+            free(s);
+            return NULL;
+        }
+    }
+    s->fd = open(s->path, O_RDONLY|O_DIRECT);
+    s->direct = s->fd >= 0;
+    if(!s->direct) {
+        s->fd = open(s->path, O_RDONLY);
+        if(s->fd < 0) {
+            fprintf(stderr, "cannot read %s: %s\n", s->path, strerror(errno));
+            free(s->bufs[0]);
+            free(s->bufs[1]);
+            free(s);
+            return NULL;
+        }
+        posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#ifdef BIGO_IO_URING
+    s->using_uring = uring_open_1(&s->uring);
+#endif
+    if(!s->using_uring) stream_reader_start_1(s);
+    return s;
+}
+void stream_close(struct stream *s) {
+    if(s->in_flight) stream_wait_1(s);
+#ifdef BIGO_IO_URING
+    if(s->using_uring) uring_close_1(&s->uring);
+#endif
+    if(s->reader) {
+        pthread_mutex_lock(&s->reader->lock);
+        s->reader->quit = 1;
+        pthread_cond_broadcast(&s->reader->cond);
+        pthread_mutex_unlock(&s->reader->lock);
+        pthread_join(s->reader->thread, NULL);
+        pthread_mutex_destroy(&s->reader->lock);
+        pthread_cond_destroy(&s->reader->cond);
+        free(s->reader);
+    }
+    close(s->fd);
+    if(!s->keep) unlink(s->path);
+    free(s->bufs[0]);
+    free(s->bufs[1]);
+    free(s);
+}
+
+/* [=] linear_search a chunk at a
+ * time (on the vector kernel)
+ * for the last item - so the
+ * whole file is read (unless
+ * the same value turns up
+ * earlier).
+ */
+int stream_linear_search(struct stream *s, double *result) {
+    long at = s->sz - 1, first = 0, count, pos = -1;
+    int needle = stream_value_1(at);
+    int *vals;
+
+    while(pos < 0 && (count = stream_next(s, &vals)) > 0) {
+        long k = find_first_engine.find(vals, count, needle);
+        if(k >= 0) pos = first + k;
+        first += count;
+    }
+    *result = pos;
+    if(pos >= 0 && pos <= at) return 1;
+    fprintf(stderr, "stream_linear_search: found %ld, expected by %ld\n", pos, at);
+    return 0;
+}
+
+/* Range sums in one pass: a
+ * query's sum is the running
+ * total just after `to` less
+ * the one just before `from`.
+ * So each query is two events -
+ * catch the running total at
+ * these items - sorted by item.
+ */
+struct stream_event {
+    long at;
+    long q;
+    int end;
+};
+int cmp_stream_event(const void *a, const void *b) {
+    const struct stream_event *x = a, *y = b;
+    return x->at < y->at ? -1 : x->at > y->at;
+}
+int stream_range_sums(struct stream *s, double *result) {
+    struct rng rng = rng_create(options.seed, RANGE_OPS_STREAM);
+    long num = options.range_ops, e = 0, q, first = 0, count;
+    struct stream_event *events = malloc(sizeof(struct stream_event)*2*num);
+    long long *sums = calloc(num, sizeof(long long));
+    long long total = 0, checksum = 0;
+    int *vals;
+
+    for(q = 0;q < num;q++) {
+        long from = rng_below(&rng, s->sz), to = rng_below(&rng, s->sz);
+        if(from > to) {
+            long t = from;
+            from = to;
+            to = t;
+        }
+        events[2*q] = (struct stream_event){ from, q, 0 };
+        events[2*q+1] = (struct stream_event){ to + 1, q, 1 };
+    }
+    qsort(events, 2*num, sizeof(struct stream_event), cmp_stream_event);
+
+    while((count = stream_next(s, &vals)) > 0) {
+        long i = 0;
+        for(;;) {
+            long stop = count;
+            for(;e < 2*num && events[e].at == first + i;e++) {
+                sums[events[e].q] += events[e].end ? total : -total;
+            }
+            if(e < 2*num && events[e].at - first < count) stop = events[e].at - first;
+            for(;i < stop;i++) total += vals[i];
+            if(i == count) break;
+        }
+        first += count;
+    }
+    for(;e < 2*num;e++) sums[events[e].q] += events[e].end ? total : -total;
+    for(q = 0;q < num;q++) checksum += sums[q];
+
+    free(events);
+    free(sums);
+    *result = checksum;
+    /* a read that failed ends the
+     * stream early */
+    return first == s->sz;
+}
+
+/* [=] Kadane carries straight
+ * over from chunk to chunk */
+int stream_kadane(struct stream *s, double *result) {
+    long long best = 0, curr = 0;
+    long count, i;
+    int *vals;
+
+    while((count = stream_next(s, &vals)) > 0) {
+        for(i = 0;i < count;i++) {
+            curr += vals[i];
+            if(curr < 0) curr = 0;
+            if(curr > best) best = curr;
+        }
+    }
+    *result = best;
+    return s->items == s->sz;
+}
+
+/* External merge sort: sort
+ * each chunk (with the --sort
+ * engine) into a run on disk,
+ * then merge all the runs at
+ * once through a heap, reading
+ * each a block at a time. The
+ * output is checked as it is
+ * written.
+ */
+struct merge_run {
+    long next;
+    long end;
+    int *buf;
+    long pos;
+    long len;
+};
+int merge_head_1(struct merge_run *runs, int r) {
+    return runs[r].buf[runs[r].pos];
+}
+void merge_sift_1(struct merge_run *runs, int *heap, int num, int i) {
+    for(;;) {
+        int l = 2*i + 1, m = i;
+        if(l < num && merge_head_1(runs, heap[l]) < merge_head_1(runs, heap[m])) m = l;
+        if(l + 1 < num && merge_head_1(runs, heap[l+1]) < merge_head_1(runs, heap[m])) m = l + 1;
+        if(m == i) return;
+        int t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+/* [=] The next block of a run.
+ * Returns 0 when it is done. */
+int merge_fill_1(int fd, struct merge_run *run, long block) {
+    long count = run->end - run->next < block ? run->end - run->next : block;
+
+    if(count <= 0) return 0;
+    if(read_fully_1(fd, run->buf, count*sizeof(int), run->next*sizeof(int)) != (ssize_t)(count*sizeof(int))) return 0;
+    run->next += count;
+    run->pos = 0;
+    run->len = count;
+    return 1;
+}
+int stream_merge_sort(struct stream *s, double *result) {
+    int runs_fd = stream_temp_1(), out_fd = stream_temp_1();
+    long first = 0, count, num_runs = 0, block, r, written = 0, num_out = 0;
+    long long in_sum = 0, out_sum = 0;
+    struct merge_run *runs;
+    int *heap, *out, *vals, sorted = 1, prev = INT32_MIN, num;
+    struct array chunk;
+    long i;
+
+    if(runs_fd < 0 || out_fd < 0) return 0;
+    while((count = stream_next(s, &vals)) > 0) {
+        for(i = 0;i < count;i++) in_sum += vals[i];
+        chunk.sz = count;
+        chunk.vals = vals;
+        options.sort->sort(&chunk);
+        if(!write_fully_1(runs_fd, vals, count*sizeof(int), first*sizeof(int))) {
+            fprintf(stderr, "stream_merge_sort: cannot write run %ld\n", num_runs);
+            close(runs_fd);
+            close(out_fd);
+            return 0;
+        }
+        first += count;
+        num_runs++;
+    }
+
+    /* every run gets an equal share
+     * of a chunk's worth of memory */
+    block = s->chunk / (num_runs + 1);
+    if(block < 1024) block = 1024;
+    runs = malloc(sizeof(struct merge_run)*num_runs);
+    heap = malloc(sizeof(int)*num_runs);
+    out = malloc(sizeof(int)*block);
+    num = 0;
+    for(r = 0;r < num_runs;r++) {
+        runs[r].next = r*s->chunk;
+        runs[r].end = runs[r].next + s->chunk < first ? runs[r].next + s->chunk : first;
+        runs[r].buf = malloc(sizeof(int)*block);
+        if(merge_fill_1(runs_fd, &runs[r], block)) heap[num++] = r;
+    }
+    for(i = num/2 - 1;i >= 0;i--) merge_sift_1(runs, heap, num, i);
+    while(num > 0) {
+        struct merge_run *run = &runs[heap[0]];
+        int v = run->buf[run->pos++];
+
+        if(v < prev) sorted = 0;
+        prev = v;
+        out_sum += v;
+        out[num_out++] = v;
+        if(num_out == block) {
+            if(write_fully_1(out_fd, out, num_out*sizeof(int), written*sizeof(int))) written += num_out;
+            num_out = 0;
+        }
+        if(run->pos == run->len && !merge_fill_1(runs_fd, run, block)) heap[0] = heap[--num];
+        merge_sift_1(runs, heap, num, 0);
+    }
+    if(write_fully_1(out_fd, out, num_out*sizeof(int), written*sizeof(int))) written += num_out;
+
+    /* only what reached the file
+     * counts as written */
+    if(!sorted || written != s->sz || out_sum != in_sum) {
+        fprintf(stderr, "stream_merge_sort: output %s (%ld of %ld items written)\n", sorted ? "lost items" : "out of order", written, s->sz);
+    }
+    for(r = 0;r < num_runs;r++) free(runs[r].buf);
+    free(runs);
+    free(heap);
+    free(out);
+    close(runs_fd);
+    close(out_fd);
+    *result = num_runs;
+    return sorted && written == s->sz && out_sum == in_sum;
+}
+
+struct stream_algorithm {
+    char *name;
+    enum OClass oclass;
+    /* returns 0 if it went wrong */
+    int (*run)(struct stream *s, double *result);
+};
+static struct stream_algorithm stream_algorithms[] = {
+    { "stream_linear_search", O_n, &stream_linear_search },
+    { "stream_range_sums", O_n, &stream_range_sums },
+    { "stream_kadane", O_n, &stream_kadane },
+    { "stream_merge_sort", O_nlogn, &stream_merge_sort },
+    { NULL, O1, NULL },
+};
+
+/* [=] Run each stream algorithm
+ * once over the whole stream
+ * (there is no sampling - one
+ * pass is the point) and show
+ * the time per item and the
+ * rate the items went by.
+ * Returns how many failed, or
+ * -1 if there is no stream.
+ */
+int show_stream_results(long sz) {
+    struct stream_algorithm *algorithm;
+    struct stream *s = stream_open(sz);
+    regex_t re;
+    int filter, failed = 0;
+
+    if(!s) return -1;
+    filter = options.only && !regcomp(&re, options.only, REG_EXTENDED|REG_NOSUB);
+    if(options.format == TEXT_FORMAT) {
+        printf("streaming %ld items (", sz);
+        show_bytes_msg_1((double)sz*sizeof(int));
+        printf(") from %s in chunks of %ld via %s%s\n", s->path, s->chunk,
+                s->using_uring ? "io_uring" : "a reader thread", s->direct ? " (O_DIRECT)" : "");
+    }
+    for(algorithm = stream_algorithms;algorithm->name;algorithm++) {
+        struct environment environment = { .name = algorithm->name, .n = sz, .oclass = algorithm->oclass };
+        struct stats stats;
+        long long begin, end;
+        double result, ns;
+        int ok;
+
+        if(filter && regexec(&re, algorithm->name, 0, NULL, 0)) continue;
+        reset_peak_rss();
+        stats.rss = status_bytes_1("VmRSS");
+        stream_rewind(s);
+        begin = now_ns();
+        ok = algorithm->run(s, &result);
+        RESULT(result);
+        end = now_ns();
+        stats.peak_rss = peak_rss();
+        environment.io_bytes = s->items*(long long)sizeof(int);
+        environment.io_wait_ns = s->wait_ns;
+        failed += !ok;
+
+        ns = end - begin;
+        stats.samples = stats.iters = 1;
+        stats.over_budget = 0;
+        stats.min = stats.median = stats.mean = stats.p99 = ns;
+        stats.stddev = 0;
+        memset(stats.counters, 0, sizeof(stats.counters));
+        if(options.format != TEXT_FORMAT) {
+            report_row(&environment, &stats, ok ? "ok" : "failed", options.threads);
+            continue;
+        }
+        show_row_head_1(&environment);
+        if(!ok) {
+            printf("FAILED\n");
+            continue;
+        }
+        printf("took ");
+        show_time_msg_1(ns);
+        printf("  %.3f GB/s  %.3f ns/elem", environment.io_bytes / ns, ns / s->items);
+        printf("  io wait %.0f%%  rss ", 100.0 * environment.io_wait_ns / ns);
+        show_bytes_msg_1(stats.peak_rss);
+        printf("\n");
+    }
+    if(filter) regfree(&re);
+    stream_close(s);
+    return failed;
+}
+
+/* (compare runs) */
+
+/* A result read back in. A file
+ * may hold several independent
+ * runs of the same environment.
+ */
+struct result {
+    char name[64];
+    char status[32];
+    long n;
+    int threads;
+    double median;
+};
+struct results {
+    struct result *results;
+    int num;
+};
+
+/* [=] Find "key": in a json
+ * record and point past it
+ */
+char* json_field_1(char *line, char *key) {
+    char pat[80];
+    char *p;
+
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    p = strstr(line, pat);
+    if(!p) return NULL;
+    p += strlen(pat);
+    while(*p == ' ') p++;
+    return p;
+}
+double json_num_1(char *line, char *key) {
+    char *p = json_field_1(line, key);
+    return p ? strtod(p, NULL) : 0;
+}
+void json_text_1(char *line, char *key, char *out, size_t len) {
+    char *p = json_field_1(line, key);
+    size_t i = 0;
+
+    if(p && *p == '"') {
+        for(p++;*p && *p != '"' && i + 1 < len;p++) {
+            if(*p == '\\' && p[1]) p++;
+            out[i++] = *p;
+        }
+    }
+    out[i] = 0;
+}
+/* [=] Split a csv line in place
+ * - returns the number of fields
+ */
+int csv_split_1(char *line, char **fields, int max) {
+    int num = 0;
+    char *out = line;
+
+    while(*line && *line != '\n' && num < max) {
+        fields[num++] = out;
+        if(*line == '"') {
+            for(line++;*line;line++) {
+                if(*line == '"' && line[1] == '"') line++;
+                else if(*line == '"') {
+                    line++;
+                    break;
+                }
+                *out++ = *line;
+            }
+        }
+        while(*line && *line != ',' && *line != '\n') *out++ = *line++;
+        if(*line == ',') line++;
+        *out++ = 0;
+    }
+    return num;
+}
+int csv_column_1(char **header, int num, char *name) {
+    int i;
+    for(i = 0;i < num;i++) if(!strcmp(header[i], name)) return i;
+    return -1;
+}
+/* [=] Read the records of a
+ * json or csv result file
+ */
+struct results* read_results(char *path) {
+    FILE *f = fopen(path, "r");
+    struct results *results;
+    char line[4096], head[4096];
+    char **header = NULL, **fields = NULL;
+    int num_header = 0, max_fields = 0, cap = 0, csv = -1;
+    int c_name = -1, c_status = -1, c_n = -1, c_threads = -1, c_median = -1, bad = 0;
+
+    if(!f) return NULL;
+    results = calloc(1, sizeof(struct results));
+    while(fgets(line, sizeof(line), f)) {
+        struct result r;
+
+        if(csv < 0) {
+            csv = line[0] != '[' && line[0] != '{';
+            if(csv) {
+                char *c;
+                /* a field more than the
+                 * header so longer rows
+                 * are caught */
+                for(max_fields = 2, c = line;*c;c++) if(*c == ',') max_fields++;
+                header = malloc(sizeof(char*)*max_fields);
+                fields = malloc(sizeof(char*)*max_fields);
+                strcpy(head, line);
+                num_header = csv_split_1(head, header, max_fields);
+                c_name = csv_column_1(header, num_header, "name");
+                c_status = csv_column_1(header, num_header, "status");
+                c_n = csv_column_1(header, num_header, "n");
+                c_threads = csv_column_1(header, num_header, "threads");
+                c_median = csv_column_1(header, num_header, "median_ns");
+                if(c_name < 0 || c_status < 0 || c_n < 0 || c_threads < 0 || c_median < 0) {
+                    fprintf(stderr, "%s: needs name, status, n, threads and median_ns columns\n", path);
+                    bad = 1;
+                    break;
+                }
+                continue;
+            }
+        }
+        if(csv) {
+            int num = csv_split_1(line, fields, max_fields);
+            if(num != num_header) continue;
+            snprintf(r.status, sizeof(r.status), "%s", fields[c_status]);
+            snprintf(r.name, sizeof(r.name), "%s", fields[c_name]);
+            r.n = atol(fields[c_n]);
+            r.threads = atoi(fields[c_threads]);
+            r.median = atof(fields[c_median]);
+        } else {
+            if(!json_field_1(line, "name")) continue;
+            json_text_1(line, "status", r.status, sizeof(r.status));
+            json_text_1(line, "name", r.name, sizeof(r.name));
+            r.n = (long)json_num_1(line, "n");
+            r.threads = (int)json_num_1(line, "threads");
+            r.median = json_num_1(line, "median_ns");
+        }
+        if(results->num == cap) {
+            cap = cap ? cap*2 : 64;
+            results->results = realloc(results->results, sizeof(struct result)*cap);
+        }
+        results->results[results->num++] = r;
+    }
+    fclose(f);
+    free(header);
+    free(fields);
+    if(bad) {
+        free(results->results);
+        free(results);
+        return NULL;
+    }
+    return results;
+}
+
+/* [=] Continued fraction for the
+ * incomplete beta function
+ * (Lentz's method)
+ */
+double beta_cf_1(double a, double b, double x) {
+    double c = 1, d = 1 - (a + b) * x / (a + 1), h;
+    int m;
+
+    if(fabs(d) < 1e-300) d = 1e-300;
+    d = 1 / d;
+    h = d;
+    for(m = 1;m < 300;m++) {
+        double aa = m * (b - m) * x / ((a + 2*m - 1) * (a + 2*m)), del;
+        d = 1 + aa * d;
+        c = 1 + aa / c;
+        if(fabs(d) < 1e-300) d = 1e-300;
+        if(fabs(c) < 1e-300) c = 1e-300;
+        d = 1 / d;
+        h *= d * c;
+        aa = -(a + m) * (a + b + m) * x / ((a + 2*m) * (a + 2*m + 1));
+        d = 1 + aa * d;
+        c = 1 + aa / c;
+        if(fabs(d) < 1e-300) d = 1e-300;
+        if(fabs(c) < 1e-300) c = 1e-300;
+        d = 1 / d;
+        del = d * c;
+        h *= del;
+        if(fabs(del - 1) < 1e-12) break;
+    }
+    return h;
+}
+/* [=] Regularised incomplete
+ * beta I_x(a, b)
+ */
+double incomplete_beta(double a, double b, double x) {
+    double front;
+
+    if(x <= 0) return 0;
+    if(x >= 1) return 1;
+    front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x));
+    if(x < (a + 1) / (a + b + 2)) return front * beta_cf_1(a, b, x) / a;
+    return 1 - front * beta_cf_1(b, a, 1 - x) / b;
+}
+/* The runs of one environment
+ * in a file: how many, the mean
+ * and spread of their medians,
+ * and whether they all finished.
+ */
+struct run_set {
+    int num;
+    int all_ok;
+    double mean;
+    double stddev;
+};
+
+/* [=] Gather the runs in
+ * `results` of the environment
+ * `r` is one of
+ */
+void run_set_1(struct results *results, struct result *r, struct run_set *set) {
+    double sum = 0, var = 0;
+    int i;
+
+    set->num = 0;
+    set->all_ok = 1;
+    for(i = 0;i < results->num;i++) {
+        struct result *f = &results->results[i];
+        if(strcmp(f->name, r->name) || f->n != r->n || f->threads != r->threads) continue;
+        if(strcmp(f->status, "ok")) {
+            set->all_ok = 0;
+            continue;
+        }
+        sum += f->median;
+        set->num++;
+    }
+    set->mean = set->num ? sum / set->num : 0;
+    for(i = 0;i < results->num;i++) {
+        struct result *f = &results->results[i];
+        if(strcmp(f->name, r->name) || f->n != r->n || f->threads != r->threads || strcmp(f->status, "ok")) continue;
+        var += (f->median - set->mean) * (f->median - set->mean);
+    }
+    set->stddev = set->num > 1 ? sqrt(var / (set->num - 1)) : 0;
+    if(!set->num) set->all_ok = 0;
+}
+/* [=] Two sided p value of Welch's
+ * t-test on the run medians - how
+ * likely the two differ by
+ * chance. The samples inside one
+ * run move together so only the
+ * spread between runs counts. A
+ * side with one run borrows the
+ * other's spread; -1 when both
+ * have one (no spread to judge
+ * by).
+ */
+double runs_p_value(struct run_set *a, struct run_set *b) {
+    double sa, sb, va, vb, se, t, df;
+
+    if(a->num < 2 && b->num < 2) return -1;
+    sa = a->num > 1 ? a->stddev : b->stddev;
+    sb = b->num > 1 ? b->stddev : a->stddev;
+    va = sa * sa / a->num;
+    vb = sb * sb / b->num;
+    se = va + vb;
+    if(se <= 0) return a->mean == b->mean ? 1 : 0;
+    t = (b->mean - a->mean) / sqrt(se);
+    if(a->num > 1 && b->num > 1) df = se * se / (va * va / (a->num - 1) + vb * vb / (b->num - 1));
+    else df = (a->num > 1 ? a->num : b->num) - 1;
+    return incomplete_beta(df / 2, 0.5, df / (df + t * t));
+}
+
+/* A change is real when its p
+ * value is under this - and it
+ * must also be bigger than
+ * --threshold percent to count.
+ * With one run a side only the
+ * threshold is left to go by.
+ */
+#define COMPARE_ALPHA 0.01
+
+/* [=] The first record of the
+ * same environment (or NULL)
+ */
+struct result* find_result_1(struct results *results, struct result *r) {
+    int i;
+    for(i = 0;i < results->num;i++) {
+        struct result *f = &results->results[i];
+        if(!strcmp(f->name, r->name) && f->n == r->n && f->threads == r->threads) return f;
+    }
+    return NULL;
+}
+/* [=] The mean run median or how
+ * the runs ended if none did
+ */
+void show_run_set_1(struct run_set *set, struct result *r) {
+    if(!r) printf("%10s", "missing");
+    else if(set->num) show_time_msg_1(set->mean);
+    else if(!strcmp(r->status, "over_budget")) printf("%10s", "> budget");
+    else if(!strcmp(r->status, "not_executed")) printf("%10s", "not run");
+    else printf("%10.10s", r->status);
+}
+/* [=] Compare two result files
+ * environment by environment.
+ * Returns how many regressed -
+ * an environment that no longer
+ * finishes (or is gone) counts.
+ */
+int compare_results(char *old_path, char *new_path) {
+    struct results *old = read_results(old_path), *new = read_results(new_path);
+    int i, regressions = 0;
+
+    if(!old || !new) {
+        printf("Cannot read %s\n", !old ? old_path : new_path);
+        return -1;
+    }
+    printf("%-24s%12s%8s%7s%14s%14s%9s%10s\n", "", "n", "threads", "runs", "old median", "new median", "change", "p");
+    for(i = 0;i < new->num;i++) {
+        struct result *b = &new->results[i], *a = find_result_1(old, b);
+        struct run_set as, bs;
+        char *verdict = "";
+
+        /* once per environment */
+        if(!a || find_result_1(new, b) != b) continue;
+        run_set_1(old, a, &as);
+        run_set_1(new, b, &bs);
+        if(!as.all_ok && !bs.num) continue;
+
+        printf("%-24s%12ld%8d%4d/%-2d ", b->name, b->n, b->threads, as.num, bs.num);
+        show_run_set_1(&as, a);
+        printf("    ");
+        show_run_set_1(&bs, b);
+        if(as.all_ok && !bs.all_ok) {
+            printf("%19s  <- REGRESSION\n", "");
+            regressions++;
+        } else if(as.num && bs.num) {
+            double change = (bs.mean - as.mean) / as.mean * 100;
+            double p = runs_p_value(&as, &bs);
+            int real = p < 0 || p < COMPARE_ALPHA;
+            if(real && change > options.threshold) {
+                verdict = "  <- REGRESSION";
+                regressions++;
+            } else if(real && change < -options.threshold) {
+                verdict = "  (faster)";
+            }
+            if(p < 0) printf("  %+6.1f%%  %8s%s\n", change, "-", verdict);
+            else printf("  %+6.1f%%  %8.2g%s\n", change, p, verdict);
+        } else {
+            printf("%19s  (now ok)\n", "");
+        }
+    }
+    for(i = 0;i < old->num;i++) {
+        struct result *a = &old->results[i];
+        struct run_set as;
+
+        if(find_result_1(old, a) != a || find_result_1(new, a)) continue;
+        run_set_1(old, a, &as);
+        if(!as.all_ok) continue;
+        printf("%-24s%12ld%8d%4d/%-2d ", a->name, a->n, a->threads, as.num, 0);
+        show_run_set_1(&as, a);
+        printf("    ");
+        show_run_set_1(NULL, NULL);
+        printf("%19s  <- REGRESSION\n", "");
+        regressions++;
+    }
+    printf("%d regression%s (over %g%% slower and p < %g across runs, or no longer ok)\n",
+            regressions, regressions == 1 ? "" : "s", options.threshold, COMPARE_ALPHA);
+    return regressions;
+}
+
+/* [=] Parse the command line
+ * into `options`. Returns 0 on
+ * bad usage.
+ */
+int parse_options(int argc, char* argv[]) {
+    int i;
+
+    for(i = 1;i < argc;i++) {
+        if(!strcmp(argv[i], "--sweep") && i+1 < argc) options.sweep = argv[++i];
+        else if(!strcmp(argv[i], "--samples") && i+1 < argc) options.samples = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--threads") && i+1 < argc) options.threads = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--batch") && i+1 < argc) options.batch = atol(argv[++i]);
+        else if(!strcmp(argv[i], "--range-ops") && i+1 < argc) options.range_ops = atol(argv[++i]);
+        else if(!strcmp(argv[i], "--updates") && i+1 < argc) options.updates = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--slice") && i+1 < argc) options.slice = atol(argv[++i]);
+        else if(!strcmp(argv[i], "--budget") && i+1 < argc) options.budget = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--compare") && i+2 < argc) {
+            options.compare[0] = argv[++i];
+            options.compare[1] = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--counters")) options.counters = 1;
+        else if(!strcmp(argv[i], "--isolated")) options.isolated = 1;
+        else if(!strcmp(argv[i], "--verify")) options.verify = 1;
+        else if(!strcmp(argv[i], "--stream") && i+1 < argc) options.stream = (long)atof(argv[++i]);
+        else if(!strcmp(argv[i], "--chunk") && i+1 < argc) options.chunk = (long)atof(argv[++i]);
+        else if(!strcmp(argv[i], "--jobs") && i+1 < argc) options.jobs = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--threshold") && i+1 < argc) options.threshold = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--format") && i+1 < argc) {
+            i++;
+            if(!strcmp(argv[i], "text")) options.format = TEXT_FORMAT;
+            else if(!strcmp(argv[i], "json")) options.format = JSON_FORMAT;
+            else if(!strcmp(argv[i], "csv")) options.format = CSV_FORMAT;
+            else return 0;
+        }
+        else if(!strcmp(argv[i], "--only") && i+1 < argc) options.only = argv[++i];
+        else if(!strcmp(argv[i], "--cache") && i+1 < argc) options.cache = argv[++i];
+        else if(!strcmp(argv[i], "--seed") && i+1 < argc) options.seed = strtoull(argv[++i], NULL, 0);
+        else if(!strcmp(argv[i], "--dist") && i+1 < argc) {
+            int d = UNIFORM;
+            i++;
+            while(d <= ZIPF && strcmp(distribution_1_str(d), argv[i])) d++;
+            if(d > ZIPF) return 0;
+            options.distribution = d;
+        }
+        else if(!strcmp(argv[i], "--sort") && i+1 < argc) {
+            struct sort_engine *engine = sort_engines;
+            i++;
+            while(engine->name && strcmp(engine->name, argv[i])) engine++;
+            if(!engine->name) return 0;
+            options.sort = engine;
+        }
+        else if(argv[i][0] == '-') return 0;
+        else options.sz = atol(argv[i]);
+    }
+    if(options.samples < 1 || options.threads < 1 || options.batch < 1) return 0;
+    if(options.range_ops < 1 || options.updates < 0 || options.updates > 100) return 0;
+    if(options.slice < 0 || options.budget < 0 || options.jobs < 0) return 0;
+    if(options.stream < 0 || options.chunk < 0) return 0;
+    /* the haystacks are sorted on
+     * all threads unless told
+     * otherwise */
+    if(!options.sort) {
+        /* quick_sort's first item pivot
+         * is quadratic (and recurses n
+         * deep) on anything but
+         * random input */
+        if(options.distribution != UNIFORM) options.sort = &sort_engines[1];
+        else options.sort = &sort_engines[options.threads > 1 ? 2 : 0];
+    }
+    return options.sz || options.sweep || options.compare[0] || options.stream;
+}
+
+int main(int argc, char* argv[]) {
+    int failed;
+
+    if(!parse_options(argc, argv)) {
+        printf("Usage: %s [options] <number of items>\n"
+               "       %s [options] --sweep <from>:<to>:x<factor>|+<step>|cache\n"
+               "       %s [--threshold PCT] --compare <old results> <new results>\n"
+               "Options:\n"
+               "  --only REGEX   only run algorithms whose name or class matches\n"
+               "  --samples N    timed samples per algorithm (default 15)\n"
+               "  --sort ENGINE  sort used for the haystacks: quick|intro|parallel|radix\n"
+               "  --threads N    threads for the parallel engines (default 1)\n"
+               "  --batch N      needles per batch search (default 1000)\n"
+               "  --range-ops N  ops in the range sum streams (default 1000)\n"
+               "  --updates PCT  percent of those ops that are updates (default 10)\n"
+               "  --slice N      items per range sum slice (default sqrt(n))\n"
+               "  --budget SECS  time budget per algorithm, 0 for none (default 10)\n"
+               "  --seed N       seed for all the input data (default 1)\n"
+               "  --dist D       uniform|sorted|reversed|few-unique|zipf (default uniform)\n"
+               "  --cache DIR    keep generated inputs in DIR and map them on later runs\n"
+               "  --format F     text|json|csv (default text)\n"
+               "  --counters     also count cycles, instructions, cache/branch/TLB misses\n"
+               "  --jobs N       environments run at once, each on its own core (default: all cores)\n"
+               "                 they share caches and memory bandwidth, so the times are not\n"
+               "                 comparable with --isolated ones\n"
+               "  --isolated     run one environment at a time, each thread pinned to its own core\n"
+               "                 (always on for --sweep cache)\n"
+               "  --verify       check each engine's result against its reference engine\n"
+               "  --stream N     stream N items from disk through the out of core algorithms\n"
+               "  --chunk N      items read at a time when streaming (default 4194304)\n"
+               "  --threshold P  percent slower that counts as a regression (default 5)\n",
+               argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    if(options.compare[0]) {
+        return compare_results(options.compare[0], options.compare[1]) ? 1 : 0;
+    }
+
+    if(options.counters && !counters_open()) options.counters = 0;
+
+    read_topology();
+    /* the cache knees move when
+     * other environments share the
+     * caches and memory bus */
+    if(options.sweep && !strcmp(options.sweep, "cache")) options.isolated = 1;
+    /* the counters only follow the
+     * main thread */
+    if(options.isolated || options.counters) options.jobs = 1;
+    if(!options.jobs) options.jobs = topology.num_cpus;
+    if(options.isolated) {
+        pool_cpus = topology.cpus;
+        pool_num_cpus = topology.num_cpus;
+        pin_to_cpu(topology.cpus[0]);
+    }
+    bench_pool = pool_create(options.threads);
+    find_first_engine = select_find_first();
+    select_seq_lanes();
+    select_sums();
+    select_unpack();
+
+    if(options.stream) {
+        report_begin();
+        failed = show_stream_results(options.stream);
+        report_end();
+        pool_destroy(bench_pool);
+        return failed ? 1 : 0;
+    }
+
+    register_algorithms();
+    if(options.only && !filter_algorithms(options.only)) {
+        printf("Bad pattern: %s\n", options.only);
+        return 1;
+    }
+#ifdef BIGO_OFFLOAD
+    if(options.format == TEXT_FORMAT) {
+        int devices = omp_get_num_devices();
+        if(devices) printf("offloading to device %d of %d\n", omp_get_default_device(), devices);
+        else printf("no offload device - the offload rows run on the host\n");
+    }
+#endif
+
+    if(options.verify) {
+        struct sweep one = { &options.sz, 1 };
+        struct sweep *sweep = &one;
+
+        if(options.sweep && !strcmp(options.sweep, "cache")) sweep = cache_sweep();
+        else if(options.sweep) sweep = parse_sweep(options.sweep);
+        if(!sweep) {
+            printf("Bad sweep: %s (eg: 1e3:1e7:x2)\n", options.sweep);
+            return 1;
+        }
+        failed = verify_sweep(sweep);
+        pool_destroy(bench_pool);
+        return failed ? 1 : 0;
+    }
+
+    report_begin();
+    if(options.sweep) {
+        struct sweep *sweep;
+        if(!strcmp(options.sweep, "cache")) {
+            sweep = cache_sweep();
+            options.per_unit = 1;
+            if(!sweep) {
+                printf("Cannot find the cache sizes for the cache sweep\n");
+                return 1;
+            }
+        } else {
+            sweep = parse_sweep(options.sweep);
+        }
+        if(!sweep) {
+            printf("Bad sweep: %s (eg: 1e3:1e7:x2)\n", options.sweep);
+            return 1;
+        }
+        show_sweep_results(sweep);
+    } else {
+        show_algo_results(options.sz);
+    }
+    report_end();
+
+    pool_destroy(bench_pool);
+    return 0;
+}